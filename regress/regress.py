@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+# performance regression runner:
+# runs the fixed matrix in matrix.json, each case with --report=<jsonl>, and
+# compares the selected metric against this host's baseline file;
+# exit status 0: no significant slowdown, 1: slowdown(s), 2: a case failed to run
+#
+# a case is a slowdown when its metric moved the wrong way by more than the
+# case's tolerance band and by more than the 95% CIs of baseline and run;
+# cases the host cannot run (too few cores, no hugepages) are skipped
+#
+#   ./regress/regress.py --update            record baselines/<hostname>.json
+#   ./regress/regress.py                     compare against it
+#   ./regress/regress.py --host=skylake-2s   share a baseline across a SKU
+#   ./regress/regress.py --cases=lat_dram,bw_prd_dram --tolerance-scale=2
+
+import argparse
+import glob
+import json
+import os
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+REGRESS_DIR = os.path.dirname(os.path.abspath(__file__))
+TOP_DIR = os.path.dirname(REGRESS_DIR)
+
+EXIT_PASS = 0
+EXIT_SLOWDOWN = 1
+EXIT_ERROR = 2
+
+# host keys that must match the baseline for the comparison to make sense;
+# kernel, firmware etc. are expected to change, that is what we gate
+HOST_IDENTITY = ['cpu_model', 'num_cpus', 'num_cores', 'num_packages', 'num_nodes']
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='run the regression matrix and compare against the host baseline')
+    parser.add_argument('--bin-dir', default=os.path.join(TOP_DIR, 'build', 'x86', 'bin', 'benchmark'),
+                        help='directory of the benchmark binaries')
+    parser.add_argument('--matrix', default=os.path.join(REGRESS_DIR, 'matrix.json'))
+    parser.add_argument('--baseline-dir', default=os.path.join(REGRESS_DIR, 'baselines'))
+    parser.add_argument('--host', default=socket.gethostname().split('.')[0],
+                        help='baseline name, e.g. one per SKU instead of per hostname')
+    parser.add_argument('--cases', default='', help='comma-separated case names, default all')
+    parser.add_argument('--tolerance-scale', type=float, default=1.0,
+                        help='multiply every tolerance band, e.g. 2 on a noisy host')
+    parser.add_argument('--update', action='store_true',
+                        help='record the results as the new baseline instead of comparing')
+    parser.add_argument('--results', default='',
+                        help='also write the results of this run to a json file')
+    parser.add_argument('--list', action='store_true', help='print the matrix and exit')
+    parser.add_argument('--verbose', action='store_true', help='show the benchmark output')
+    return parser.parse_args()
+
+
+# cores and hugepages this process may use
+def host_resources():
+    cpus = sorted(os.sched_getaffinity(0))
+    cores = set()
+    for cpu in cpus:
+        topology = '/sys/devices/system/cpu/cpu%d/topology/' % cpu
+        try:
+            with open(topology + 'physical_package_id') as f:
+                package = f.read().strip()
+            with open(topology + 'core_id') as f:
+                core = f.read().strip()
+        except OSError:
+            package, core = '0', str(cpu)
+        cores.add((package, core))
+    hugepages = 0
+    try:
+        with open('/proc/meminfo') as f:
+            for line in f:
+                if line.startswith('HugePages_Total:'):
+                    hugepages = int(line.split()[1])
+    except OSError:
+        pass
+    return len(cores), hugepages
+
+
+def skip_reason(case, num_cores, hugepages):
+    if case.get('min_cores', 1) > num_cores:
+        return 'needs %d cores, have %d' % (case['min_cores'], num_cores)
+    if case.get('hugepages', False) and hugepages == 0:
+        return 'needs hugepages (HugePages_Total=0)'
+    return ''
+
+
+# run one case; returns the one report record its "select" matches
+def run_case(case, args):
+    binary = os.path.join(args.bin_dir, case['binary'])
+    if not os.access(binary, os.X_OK):
+        raise RuntimeError('missing binary %s' % binary)
+    fd, report = tempfile.mkstemp(prefix='regress_%s_' % case['name'], suffix='.jsonl')
+    os.close(fd)
+    try:
+        cmd = [binary] + case['args'] + ['--report=' + report]
+        if args.verbose:
+            print('  $ ' + ' '.join(cmd))
+        proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+        if args.verbose:
+            sys.stdout.write(proc.stdout)
+        if proc.returncode != 0:
+            tail = '\n'.join(proc.stdout.splitlines()[-5:])
+            raise RuntimeError('exit status %d\n%s' % (proc.returncode, tail))
+        with open(report) as f:
+            records = [json.loads(line) for line in f if line.strip()]
+    finally:
+        os.unlink(report)
+    selected = [r for r in records
+                if all(r['config'].get(k) == v for k, v in case.get('select', {}).items())]
+    if len(selected) != 1:
+        raise RuntimeError('%d records match %s' % (len(selected), case.get('select', {})))
+    record = selected[0]
+    if record['metrics'].get(case['metric']) is None:
+        raise RuntimeError('no metric %s' % case['metric'])
+    return record
+
+
+def to_result(case, record):
+    metrics = record['metrics']
+    return {
+        'metric': case['metric'],
+        'value': metrics[case['metric']],
+        # half-width of the 95% CI when the case repeats its measurement
+        'ci95': metrics.get(case['metric'] + '_ci95') or 0,
+        'samples': metrics.get(case['metric'] + '_n', 1),
+        'config': record['config'],
+    }
+
+
+# signed change in the "worse" direction, as a fraction of the baseline
+def slowdown(case, base, current):
+    if base == 0:
+        return 0
+    change = (current - base) / base
+    return change if case['better'] == 'lower' else -change
+
+
+def compare(case, base, current, scale):
+    worse = slowdown(case, base['value'], current['value'])
+    tolerance = case['tolerance'] * scale
+    # beyond the band, and beyond what the run-to-run noise of both sides explains
+    noise = (base.get('ci95', 0) + current['ci95']) / abs(base['value']) if base['value'] else 0
+    if worse > tolerance and worse > noise:
+        return 'SLOWER', worse
+    if -worse > tolerance and -worse > noise:
+        return 'FASTER', worse
+    return 'PASS', worse
+
+
+def check_host(baseline_host, host):
+    mismatches = []
+    for key in HOST_IDENTITY:
+        if key in baseline_host and baseline_host.get(key) != host.get(key):
+            mismatches.append('%s: baseline %s, now %s' % (key, baseline_host.get(key), host.get(key)))
+    return mismatches
+
+
+def main():
+    args = parse_args()
+    with open(args.matrix) as f:
+        matrix = json.load(f)
+    if args.cases:
+        names = args.cases.split(',')
+        unknown = set(names) - set(case['name'] for case in matrix)
+        if unknown:
+            print('unknown cases: ' + ', '.join(sorted(unknown)))
+            return EXIT_ERROR
+        matrix = [case for case in matrix if case['name'] in names]
+    if args.list:
+        for case in matrix:
+            print('%-22s %-14s %s  [%s, %s is better, +-%.0f%%]' % (
+                case['name'], case['binary'], ' '.join(case['args']),
+                case['metric'], case['better'], 100 * case['tolerance']))
+        return EXIT_PASS
+    baseline_path = os.path.join(args.baseline_dir, args.host + '.json')
+    baseline = None
+    if not args.update:
+        if not os.path.exists(baseline_path):
+            known = [os.path.basename(p)[:-5] for p in glob.glob(os.path.join(args.baseline_dir, '*.json'))]
+            print('no baseline %s; record one with --update (known: %s)' % (
+                baseline_path, ', '.join(sorted(known)) or 'none'))
+            return EXIT_ERROR
+        with open(baseline_path) as f:
+            baseline = json.load(f)
+    num_cores, hugepages = host_resources()
+    results = {}
+    host = {}
+    status = EXIT_PASS
+    print('%-22s %14s %14s %9s %9s  %s' % ('case', 'baseline', 'current', 'change', 'band', 'status'))
+    for case in matrix:
+        reason = skip_reason(case, num_cores, hugepages)
+        if reason:
+            print('%-22s %14s %14s %9s %9s  SKIP (%s)' % (case['name'], '', '', '', '', reason))
+            continue
+        try:
+            record = run_case(case, args)
+        except RuntimeError as e:
+            print('%-22s %14s %14s %9s %9s  ERROR (%s)' % (case['name'], '', '', '', '', e))
+            status = EXIT_ERROR
+            continue
+        host = record['host']
+        current = to_result(case, record)
+        results[case['name']] = current
+        base = baseline['results'].get(case['name']) if baseline else None
+        if base is None:
+            verdict, worse = ('RECORDED' if args.update else 'NEW'), 0
+        else:
+            verdict, worse = compare(case, base, current, args.tolerance_scale)
+            if verdict == 'SLOWER' and status == EXIT_PASS:
+                status = EXIT_SLOWDOWN
+        # printed so that + is always worse
+        print('%-22s %14.3f %14.3f %8.1f%% %8.1f%%  %s' % (
+            case['name'], base['value'] if base else current['value'], current['value'],
+            100 * worse, 100 * case['tolerance'] * args.tolerance_scale, verdict))
+    if baseline and host:
+        for mismatch in check_host(baseline.get('host', {}), host):
+            print('warning: host differs from the baseline, ' + mismatch)
+    output = {
+        'host': host,
+        'date': time.strftime('%Y-%m-%dT%H:%M:%SZ', time.gmtime()),
+        'results': results,
+    }
+    if args.results:
+        with open(args.results, 'w') as f:
+            json.dump(output, f, indent=2, sort_keys=True)
+    if args.update:
+        if status == EXIT_ERROR:
+            print('not updating %s: some cases failed' % baseline_path)
+            return status
+        # keep cases this run skipped or did not select
+        if os.path.exists(baseline_path):
+            with open(baseline_path) as f:
+                previous = json.load(f).get('results', {})
+            previous.update(results)
+            output['results'] = previous
+        os.makedirs(args.baseline_dir, exist_ok=True)
+        with open(baseline_path, 'w') as f:
+            json.dump(output, f, indent=2, sort_keys=True)
+        print('baseline written to %s' % baseline_path)
+    return status
+
+
+if __name__ == '__main__':
+    sys.exit(main())
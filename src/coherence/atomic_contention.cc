@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+#include "utils/lib_mem_region.hh"
+#include "utils/lib_options.hh"
+#include "utils/lib_report.hh"
+#include "utils/lib_threading.hh"
+#include "utils/lib_timing.hh"
+
+enum class AtomicOp { FAA, CAS, XCHG, STORE, OR };
+
+// shared lines + stop flag on a line of its own
+struct ContentionSetup {
+    char* lines;
+    uint32_t num_lines;
+    AtomicOp op;
+    std::atomic<bool>* stop;
+    pthread_barrier_t barrier;
+};
+
+class ThreadPacket : public utils::BaseThreadPacket {
+  public:
+    ThreadPacket() = default;
+    ~ThreadPacket() = default;
+
+    ContentionSetup* setup = nullptr;
+    uint64_t num_ops = 0;
+    uint64_t sink = 0;
+    double elapsed_s = 0;
+};
+
+// lines are 128B apart so the adjacent-line prefetcher doesn't pair them
+static const uint64_t LINE_STRIDE = 128;
+// ops between two checks of the stop flag
+static const uint64_t OPS_PER_CHECK = 64;
+
+template <AtomicOp kOp>
+uint64_t hammer(std::atomic<uint64_t>* line, const std::atomic<bool>* stop, uint64_t& sink)
+{
+    uint64_t num_ops = 0;
+    uint64_t value = 0;
+    do {
+        for (uint64_t k = 0; k < OPS_PER_CHECK; ++k) {
+            switch (kOp) {
+            case AtomicOp::FAA:
+                value += line->fetch_add(1);
+                break;
+            case AtomicOp::CAS: {
+                // a successful cas counts as one op
+                uint64_t expected = line->load(std::memory_order_relaxed);
+                while (!line->compare_exchange_weak(expected, expected + 1)) { }
+                value += expected;
+                break;
+            }
+            case AtomicOp::XCHG:
+                value += line->exchange(num_ops + k);
+                break;
+            case AtomicOp::STORE:
+                // plain store: ownership churn without a lock prefix
+                line->store(num_ops + k, std::memory_order_relaxed);
+                break;
+            case AtomicOp::OR:
+                // result unused, so this is a single lock or, not a cas loop
+                line->fetch_or(1ull << (k & 63));
+                break;
+            }
+        }
+        num_ops += OPS_PER_CHECK;
+    } while (!stop->load(std::memory_order_relaxed));
+    // keep the results alive
+    sink = value;
+    return num_ops;
+}
+
+void *thread_hammer(void *ptr)
+{
+    ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
+    ContentionSetup* setup = pkt->setup;
+    std::atomic<uint64_t>* line = reinterpret_cast<std::atomic<uint64_t>*>(
+        setup->lines + (pkt->getThreadId() % setup->num_lines) * LINE_STRIDE);
+    pthread_barrier_wait(&setup->barrier);
+    const auto time_begin = std::chrono::steady_clock::now();
+    switch (setup->op) {
+    case AtomicOp::FAA:  pkt->num_ops = hammer<AtomicOp::FAA>(line, setup->stop, pkt->sink); break;
+    case AtomicOp::CAS:  pkt->num_ops = hammer<AtomicOp::CAS>(line, setup->stop, pkt->sink); break;
+    case AtomicOp::XCHG: pkt->num_ops = hammer<AtomicOp::XCHG>(line, setup->stop, pkt->sink); break;
+    case AtomicOp::STORE: pkt->num_ops = hammer<AtomicOp::STORE>(line, setup->stop, pkt->sink); break;
+    case AtomicOp::OR:   pkt->num_ops = hammer<AtomicOp::OR>(line, setup->stop, pkt->sink); break;
+    }
+    const auto time_end = std::chrono::steady_clock::now();
+    pkt->elapsed_s = std::chrono::duration_cast<std::chrono::duration<double>>(
+        time_end - time_begin).count();
+    return NULL;
+}
+
+AtomicOp get_atomic_op(const std::string& op) {
+    if (op == "faa") return AtomicOp::FAA;
+    if (op == "cas") return AtomicOp::CAS;
+    if (op == "xchg") return AtomicOp::XCHG;
+    if (op == "store") return AtomicOp::STORE;
+    if (op == "or") return AtomicOp::OR;
+    std::cerr << "unknown op: " << op << std::endl;
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    utils::start_timer("startup");
+    const utils::Options options(argc, argv);
+    // input parameters
+    if (argc < 4) {
+        std::cout << "Usage: ./atomic_contention <duration_ms> <max threads>"
+            << " <thread mapping step> <core-id start>" << std::endl;
+        std::cout << "\tatomic RMWs on shared lines from 1,2,4,..,max pinned threads" << std::endl;
+        std::cout << "\tthread mapping step: e.g. 2 leads to 0,1,2,3 -> 0,2,1,3" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "\t--op=faa|cas|xchg|store|or|all: RMW flavor (default all)" << std::endl;
+        std::cout << "\t\tstore: plain store, no lock prefix; or: fetch_or with the result discarded, i.e. lock or" << std::endl;
+        std::cout << "\t--lines=K: number of shared lines, thread i hits line i%K (default 1)" << std::endl;
+        std::cout << "\t--placement=compact|scatter|core|l3|<cpu list>: placement from the cpu topology, overrides the mapping step" << std::endl;
+        std::cout << "\t\te.g. compact for hyper-thread pairs, core for one L3, scatter across sockets" << std::endl;
+        std::cout << "\t--report=<file|->: one structured record per measurement; --report_format=jsonl|csv (default by extension)" << std::endl;
+        std::cout << "Example: ./atomic_contention 200 8 1 0 --op=faa --placement=core" << std::endl;
+        exit(1);
+    }
+    const uint64_t duration_ms = strtoull(argv[1], NULL, 10);
+    const uint32_t num_cores = utils::CpuTopology::get().numCpus();
+    const uint32_t max_threads_user = atoi(argv[2]);
+    const uint32_t max_threads = (max_threads_user > 0) ? max_threads_user : num_cores;
+    const uint32_t thread_step = atoi(argv[3]);
+    uint32_t core_id_start = 0;
+    if (argc >= 5) core_id_start = atoi(argv[4]);
+    const uint32_t num_lines = std::max<uint64_t>(1, options.getUint("lines", 1));
+    const std::string placement = options.get("placement");
+    const std::string op_str = options.get("op", "all");
+    std::vector<std::string> ops;
+    if (op_str == "all") {
+        ops = {"faa", "cas", "xchg", "store", "or"};
+    } else {
+        get_atomic_op(op_str);
+        ops.push_back(op_str);
+    }
+    utils::Reporter& reporter = utils::Reporter::get();
+    reporter.open("atomic_contention", options);
+    reporter.config("duration_ms", duration_ms);
+    reporter.config("lines", num_lines);
+    // shared lines followed by the stop flag
+    const uint64_t region_size = ((num_lines + 1) * LINE_STRIDE + 4095) / 4096 * 4096;
+    utils::MemRegion line_region(region_size, region_size, 4096, 64);
+    char* lines = reinterpret_cast<char*>(line_region.getStartPoint());
+    std::atomic<bool>* stop = reinterpret_cast<std::atomic<bool>*>(lines + num_lines * LINE_STRIDE);
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t n = 1; n < max_threads; n *= 2) {
+        thread_counts.push_back(n);
+    }
+    thread_counts.push_back(max_threads);
+    utils::end_timer("startup", std::cout);
+    // run
+    utils::start_timer("all");
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << std::setw(6) << "op" << std::setw(8) << "threads"
+        << std::setw(14) << "agg(Mops/s)" << std::setw(14) << "min(Mops/s)"
+        << std::setw(14) << "max(Mops/s)" << std::setw(12) << "lat(ns)" << std::endl;
+    for (const std::string& op : ops) {
+        for (const uint32_t& num_threads : thread_counts) {
+            ContentionSetup setup;
+            setup.lines = lines;
+            setup.num_lines = num_lines;
+            setup.op = get_atomic_op(op);
+            setup.stop = stop;
+            memset(lines, 0, num_lines * LINE_STRIDE);
+            stop->store(false);
+            // workers + the main thread, which times the run
+            pthread_barrier_init(&setup.barrier, NULL, num_threads + 1);
+            const std::vector<uint32_t> core_ids = utils::CpuTopology::get().getPlacement(
+                placement, num_threads, thread_step, core_id_start);
+            utils::ThreadHelper<ThreadPacket> threads(core_ids);
+            for (uint32_t i = 0; i < num_threads; ++i) {
+                threads.getPacket(i).setup = &setup;
+            }
+            threads.setRoutine(thread_hammer, [](const uint32_t& idx) { return true; });
+            threads.create();
+            pthread_barrier_wait(&setup.barrier);
+            std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+            stop->store(true);
+            threads.join();
+            pthread_barrier_destroy(&setup.barrier);
+            // aggregate, fairness, per-op latency
+            double agg_mops = 0;
+            double min_mops = 0;
+            double max_mops = 0;
+            double lat_ns = 0;
+            for (uint32_t i = 0; i < num_threads; ++i) {
+                const ThreadPacket& pkt = threads.getPacket(i);
+                const double mops = pkt.num_ops / pkt.elapsed_s / 1e6;
+                agg_mops += mops;
+                min_mops = (i == 0) ? mops : std::min(min_mops, mops);
+                max_mops = std::max(max_mops, mops);
+                lat_ns += pkt.elapsed_s * 1e9 / pkt.num_ops / num_threads;
+            }
+            out << std::setw(6) << op << std::setw(8) << num_threads
+                << std::setw(14) << agg_mops << std::setw(14) << min_mops
+                << std::setw(14) << max_mops << std::setw(12) << lat_ns << std::endl;
+            reporter.add(utils::ResultRecord()
+                .config("op", op).config("threads", num_threads).config("cores", utils::join_list(core_ids))
+                .metric("agg_mops", agg_mops).metric("min_mops", min_mops).metric("max_mops", max_mops)
+                .metric("lat_ns", lat_ns));
+        }
+    }
+    utils::end_timer("all", std::cout);
+    std::cout << out.str();
+    return 0;
+}
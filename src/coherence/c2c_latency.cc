@@ -0,0 +1,168 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+#include "utils/lib_mem_region.hh"
+#include "utils/lib_options.hh"
+#include "utils/lib_report.hh"
+#include "utils/lib_threading.hh"
+#include "utils/lib_timing.hh"
+
+// flag line bounced between the two threads of a pair
+struct PingPongSetup {
+    std::atomic<uint64_t>* flag;
+    uint64_t num_warmup_rounds;
+    uint64_t num_rounds;
+};
+
+class ThreadPacket : public utils::BaseThreadPacket {
+  public:
+    ThreadPacket() = default;
+    ~ThreadPacket() = default;
+
+    PingPongSetup* setup = nullptr;
+    double round_trip_ns = 0;
+};
+
+// writes an odd value, waits for the partner to answer with the next even one
+void *thread_ping(void *ptr)
+{
+    ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
+    std::atomic<uint64_t>* flag = pkt->setup->flag;
+    const uint64_t num_warmup_rounds = pkt->setup->num_warmup_rounds;
+    const uint64_t num_rounds = pkt->setup->num_rounds;
+    uint64_t value = 0;
+    std::chrono::steady_clock::time_point time_begin;
+    for (uint64_t round = 0; round < num_warmup_rounds + num_rounds; ++round) {
+        if (round == num_warmup_rounds) {
+            time_begin = std::chrono::steady_clock::now();
+        }
+        flag->store(++ value, std::memory_order_release);
+        ++ value;
+        while (flag->load(std::memory_order_acquire) != value) { }
+    }
+    const auto time_end = std::chrono::steady_clock::now();
+    pkt->round_trip_ns = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(
+        time_end - time_begin).count() / num_rounds;
+    return NULL;
+}
+
+void *thread_pong(void *ptr)
+{
+    ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
+    std::atomic<uint64_t>* flag = pkt->setup->flag;
+    const uint64_t total_rounds = pkt->setup->num_warmup_rounds + pkt->setup->num_rounds;
+    uint64_t value = 1;
+    for (uint64_t round = 0; round < total_rounds; ++round) {
+        while (flag->load(std::memory_order_acquire) != value) { }
+        flag->store(++ value, std::memory_order_release);
+        ++ value;
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    utils::start_timer("startup");
+    const utils::Options options(argc, argv);
+    // input parameters
+    if (argc < 2) {
+        std::cout << "Usage: ./c2c_latency <num_rounds> <cpu list>" << std::endl;
+        std::cout << "\tround-trip latency of a cache line bounced between every ordered pair of cpus" << std::endl;
+        std::cout << "\tcpu list: e.g. 0-3,8,10-11; default all" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "\t--csv: print the matrix as comma-separated values" << std::endl;
+        std::cout << "\t--report=<file|->: one structured record per measurement; --report_format=jsonl|csv (default by extension)" << std::endl;
+        std::cout << "Example: ./c2c_latency 100000 0-7 --csv" << std::endl;
+        exit(1);
+    }
+    const uint64_t num_rounds = strtoull(argv[1], NULL, 10);
+    if (num_rounds < 1) {
+        std::cerr << "num_rounds must be at least 1" << std::endl;
+        exit(1);
+    }
+    // default: all cpus we are allowed to run on
+    const std::string cpu_list = (argc >= 3) ? argv[2] : "all";
+    std::vector<uint32_t> cpus;
+    if (cpu_list == "all") {
+        for (const utils::CpuInfo& info : utils::CpuTopology::get().getCpus()) {
+            cpus.push_back(info.cpu);
+        }
+    } else {
+        cpus = utils::parse_cpu_list(cpu_list);
+    }
+    const bool csv = options.has("csv");
+    utils::Reporter& reporter = utils::Reporter::get();
+    reporter.open("c2c_latency", options);
+    reporter.config("rounds", num_rounds);
+    // flag on its own page
+    utils::MemRegion flag_region(4096, 4096, 4096, 64);
+    std::atomic<uint64_t>* flag = reinterpret_cast<std::atomic<uint64_t>*>(flag_region.getStartPoint());
+    PingPongSetup setup;
+    setup.flag = flag;
+    setup.num_warmup_rounds = num_rounds / 10;
+    setup.num_rounds = num_rounds;
+    utils::end_timer("startup", std::cout);
+    // ordered pairs: row pings, column pongs
+    utils::start_timer("all");
+    std::vector<std::vector<double>> matrix(cpus.size(), std::vector<double>(cpus.size(), 0));
+    for (uint32_t i = 0; i < cpus.size(); ++i) {
+        for (uint32_t j = 0; j < cpus.size(); ++j) {
+            if (cpus[i] == cpus[j]) {
+                continue;
+            }
+            flag->store(0);
+            utils::ThreadHelper<ThreadPacket> threads({cpus[i], cpus[j]}, false);
+            threads.getPacket(0).setup = &setup;
+            threads.getPacket(1).setup = &setup;
+            threads.setRoutine(thread_ping, [](const uint32_t& idx) { return idx == 0; });
+            threads.setRoutine(thread_pong, [](const uint32_t& idx) { return idx == 1; });
+            threads.create();
+            threads.join();
+            matrix[i][j] = threads.getPacket(0).round_trip_ns;
+            reporter.add(utils::ResultRecord()
+                .config("from_cpu", cpus[i]).config("to_cpu", cpus[j])
+                .metric("round_trip_ns", matrix[i][j]).metric("one_way_ns", matrix[i][j] / 2));
+        }
+    }
+    utils::end_timer("all", std::cout);
+    // dump matrix in ns
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    if (csv) {
+        out << "from/to";
+        for (const uint32_t& cpu : cpus) out << "," << cpu;
+        out << std::endl;
+        for (uint32_t i = 0; i < cpus.size(); ++i) {
+            out << cpus[i];
+            for (uint32_t j = 0; j < cpus.size(); ++j) {
+                out << ",";
+                if (i != j) out << matrix[i][j];
+            }
+            out << std::endl;
+        }
+    } else {
+        out << "round-trip(ns)" << std::endl << std::setw(10) << "";
+        for (const uint32_t& cpu : cpus) out << std::setw(10) << cpu;
+        out << std::endl;
+        for (uint32_t i = 0; i < cpus.size(); ++i) {
+            out << std::setw(10) << cpus[i];
+            for (uint32_t j = 0; j < cpus.size(); ++j) {
+                if (i == j) {
+                    out << std::setw(10) << "-";
+                } else {
+                    out << std::setw(10) << matrix[i][j];
+                }
+            }
+            out << std::endl;
+        }
+    }
+    std::cout << out.str();
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+#include "utils/lib_mem_region.hh"
+#include "utils/lib_options.hh"
+#include "utils/lib_report.hh"
+#include "utils/lib_threading.hh"
+#include "utils/lib_timing.hh"
+
+// per-thread counters, placed according to the layout
+struct CounterSetup {
+    char* base;
+    uint64_t stride;
+    uint64_t num_increments;
+    pthread_barrier_t barrier;
+};
+
+class ThreadPacket : public utils::BaseThreadPacket {
+  public:
+    ThreadPacket() = default;
+    ~ThreadPacket() = default;
+
+    CounterSetup* setup = nullptr;
+    double elapsed_s = 0;
+};
+
+// each thread bumps only its own counter
+void *thread_incr(void *ptr)
+{
+    ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
+    CounterSetup* setup = pkt->setup;
+    volatile uint64_t* counter = reinterpret_cast<volatile uint64_t*>(
+        setup->base + pkt->getThreadId() * setup->stride);
+    const uint64_t num_increments = setup->num_increments;
+    pthread_barrier_wait(&setup->barrier);
+    const auto time_begin = std::chrono::steady_clock::now();
+    for (uint64_t k = 0; k < num_increments; ++k) {
+        *counter += 1;
+    }
+    const auto time_end = std::chrono::steady_clock::now();
+    pkt->elapsed_s = std::chrono::duration_cast<std::chrono::duration<double>>(
+        time_end - time_begin).count();
+    return NULL;
+}
+
+// bytes between two threads' counters
+uint64_t get_layout_stride(const std::string& layout) {
+    if (layout == "packed") {
+        // all in one 64B line
+        return sizeof(uint64_t);
+    } else if (layout == "adjacent") {
+        // own line, but pairs share a 128B prefetch block
+        return 64;
+    } else if (layout == "padded") {
+        // own 128B block
+        return 128;
+    }
+    std::cerr << "unknown layout: " << layout << std::endl;
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    utils::start_timer("startup");
+    const utils::Options options(argc, argv);
+    // input parameters
+    if (argc < 4) {
+        std::cout << "Usage: ./false_sharing <num_increments> <max threads>"
+            << " <thread mapping step> <core-id start>" << std::endl;
+        std::cout << "\tincrement throughput of per-thread counters, for 1,2,4,..,max threads" << std::endl;
+        std::cout << "\tthread mapping step: e.g. 2 leads to 0,1,2,3 -> 0,2,1,3" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "\t--layout=packed|adjacent|padded|all (default all)" << std::endl;
+        std::cout << "\t\tpacked: 8B apart within one line; adjacent: 64B apart; padded: 128B apart" << std::endl;
+        std::cout << "\t--placement=compact|scatter|core|l3|<cpu list>: placement from the cpu topology, overrides the mapping step" << std::endl;
+        std::cout << "\t--report=<file|->: one structured record per measurement; --report_format=jsonl|csv (default by extension)" << std::endl;
+        std::cout << "Example: ./false_sharing 10000000 8 1 0 --layout=all" << std::endl;
+        exit(1);
+    }
+    const uint64_t num_increments = strtoull(argv[1], NULL, 10);
+    const uint32_t num_cores = utils::CpuTopology::get().numCpus();
+    const uint32_t max_threads_user = atoi(argv[2]);
+    const uint32_t max_threads = (max_threads_user > 0) ? max_threads_user : num_cores;
+    const uint32_t thread_step = atoi(argv[3]);
+    uint32_t core_id_start = 0;
+    if (argc >= 5) core_id_start = atoi(argv[4]);
+    const std::string layout_str = options.get("layout", "all");
+    std::vector<std::string> layouts;
+    if (layout_str == "all") {
+        layouts = {"packed", "adjacent", "padded"};
+    } else {
+        get_layout_stride(layout_str);
+        layouts.push_back(layout_str);
+    }
+    utils::Reporter& reporter = utils::Reporter::get();
+    reporter.open("false_sharing", options);
+    reporter.config("increments", num_increments);
+    // counters on their own pages, large enough for the widest layout
+    const uint64_t region_size = std::max<uint64_t>(4096, (max_threads * 128 + 4095) / 4096 * 4096);
+    utils::MemRegion counter_region(region_size, region_size, 4096, 64);
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t n = 1; n < max_threads; n *= 2) {
+        thread_counts.push_back(n);
+    }
+    thread_counts.push_back(max_threads);
+    utils::end_timer("startup", std::cout);
+    // throughput in M increments/s
+    utils::start_timer("all");
+    std::vector<std::vector<double>> results(layouts.size());
+    for (uint32_t l = 0; l < layouts.size(); ++l) {
+        CounterSetup setup;
+        setup.base = reinterpret_cast<char*>(counter_region.getStartPoint());
+        setup.stride = get_layout_stride(layouts[l]);
+        setup.num_increments = num_increments;
+        for (const uint32_t& num_threads : thread_counts) {
+            memset(setup.base, 0, region_size);
+            pthread_barrier_init(&setup.barrier, NULL, num_threads);
+            const std::vector<uint32_t> core_ids = utils::CpuTopology::get().getPlacement(
+                options.get("placement"), num_threads, thread_step, core_id_start);
+            utils::ThreadHelper<ThreadPacket> threads(core_ids);
+            for (uint32_t i = 0; i < num_threads; ++i) {
+                threads.getPacket(i).setup = &setup;
+            }
+            threads.setRoutine(thread_incr, [](const uint32_t& idx) { return true; });
+            threads.create();
+            threads.join();
+            pthread_barrier_destroy(&setup.barrier);
+            double max_elapsed_s = 0;
+            for (uint32_t i = 0; i < num_threads; ++i) {
+                max_elapsed_s = std::max(max_elapsed_s, threads.getPacket(i).elapsed_s);
+            }
+            results[l].push_back(num_threads * num_increments / max_elapsed_s / 1e6);
+            reporter.add(utils::ResultRecord()
+                .config("layout", layouts[l]).config("stride", setup.stride)
+                .config("threads", num_threads).config("cores", utils::join_list(core_ids))
+                .metric("elapsed_s", max_elapsed_s).metric("mincr_per_s", results[l].back()));
+        }
+    }
+    utils::end_timer("all", std::cout);
+    // dump scaling table
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "throughput(M incr/s)" << std::endl << std::setw(10) << "threads";
+    for (const std::string& layout : layouts) out << std::setw(12) << layout;
+    out << std::endl;
+    for (uint32_t t = 0; t < thread_counts.size(); ++t) {
+        out << std::setw(10) << thread_counts[t];
+        for (uint32_t l = 0; l < layouts.size(); ++l) {
+            out << std::setw(12) << results[l][t];
+        }
+        out << std::endl;
+    }
+    std::cout << out.str();
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+#include "utils/lib_histogram.hh"
+#include "utils/lib_mem_region.hh"
+#include "utils/lib_options.hh"
+#include "utils/lib_report.hh"
+#include "utils/lib_threading.hh"
+#include "utils/lib_timing.hh"
+
+// readers pull the lines in Shared, then the writer invalidates them
+struct FanoutSetup {
+    utils::MemRegion* mem_region;
+    uint32_t num_rounds;
+    uint64_t overhead;
+    pthread_barrier_t read_done;
+    pthread_barrier_t write_done;
+};
+
+class ThreadPacket : public utils::BaseThreadPacket {
+  public:
+    ThreadPacket() = default;
+    ~ThreadPacket() = default;
+
+    FanoutSetup* setup = nullptr;
+    utils::LogHistogram hist;
+    bool bad_status = false;
+};
+
+// thread 0: time a store + drain to each line, i.e. RFO + invalidations
+void *thread_writer(void *ptr)
+{
+    ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
+    FanoutSetup* setup = pkt->setup;
+    // line addresses in chain order, so the writer never reads the lines
+    const uint64_t num_lines = setup->mem_region->numActiveLines();
+    std::vector<char**> lines(num_lines);
+    char** p = setup->mem_region->getStartPoint();
+    for (uint64_t k = 0; k < num_lines; ++k) {
+        lines[k] = p;
+        p = (char**)(*p);
+    }
+    for (uint32_t round = 0; round < setup->num_rounds + 1; ++round) {
+        pthread_barrier_wait(&setup->read_done);
+        for (uint64_t k = 0; k < num_lines; ++k) {
+            volatile uint64_t* target = reinterpret_cast<volatile uint64_t*>(lines[k] + 4);
+            const uint64_t t1 = utils::rdtscp();
+            *target = round;
+            __asm__ __volatile__("mfence" ::: "memory");
+            const uint64_t t2 = utils::rdtscp();
+            // first round only warms up the writer's side
+            if (round > 0) {
+                pkt->hist.add((t2 - t1 > setup->overhead) ? (t2 - t1 - setup->overhead) : 0);
+            }
+        }
+        pthread_barrier_wait(&setup->write_done);
+    }
+    pkt->bad_status = (p != setup->mem_region->getStartPoint());
+    return NULL;
+}
+
+// others: chase the whole chain so every line is Shared in this cache
+void *thread_reader(void *ptr)
+{
+    ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
+    FanoutSetup* setup = pkt->setup;
+    const uint64_t num_lines = setup->mem_region->numActiveLines();
+    register char** p = setup->mem_region->getStartPoint();
+    register uint64_t k = 0;
+    for (uint32_t round = 0; round < setup->num_rounds + 1; ++round) {
+        for (k = 0; k < num_lines; ++k) {
+            p = (char**)(*p);
+        }
+        pthread_barrier_wait(&setup->read_done);
+        pthread_barrier_wait(&setup->write_done);
+    }
+    pkt->bad_status = (p != setup->mem_region->getStartPoint());
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    utils::start_timer("startup");
+    const utils::Options options(argc, argv);
+    // input parameters
+    if (argc < 7) {
+        std::cout << "Usage: ./invalidation_fanout <region_size> <stride> <pattern> <num_rounds>"
+            << " <max readers> <thread mapping step> <core-id start>" << std::endl;
+        std::cout << "\tregion_size in KB; stride in B, at least 64" << std::endl;
+        std::cout << "\tpattern: stride, pageRand, allRand" << std::endl;
+        std::cout << "\tK readers share the lines, then one writer stores to each; K = 0..max readers" << std::endl;
+        std::cout << "\twriter on the first core of the mapping, readers on the following ones" << std::endl;
+        std::cout << "\tthread mapping step: e.g. 2 leads to 0,1,2,3 -> 0,2,1,3" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "\t--reader_step=S: sweep K in steps of S (default 1)" << std::endl;
+        std::cout << "\t--placement=compact|scatter|core|l3|<cpu list>: placement from the cpu topology, overrides the mapping step" << std::endl;
+        std::cout << "\t--seed=<S>: seed of the random patterns (default 0)" << std::endl;
+        std::cout << "\t--report=<file|->: one structured record per measurement; --report_format=jsonl|csv (default by extension)" << std::endl;
+        std::cout << "Example: ./invalidation_fanout 16 64 allRand 100 15 1 0" << std::endl;
+        exit(1);
+    }
+    const uint64_t region_size = strtoull(argv[1], NULL, 10);
+    const uint64_t stride = strtoull(argv[2], NULL, 10);
+    // the writer stores 8B at byte offset 32 of each element: at stride <= 32
+    // that overwrites the next element's pointer, and below 64 elements share a line
+    if (stride < 64) {
+        std::cerr << "stride=" << stride << " must be at least 64" << std::endl;
+        exit(1);
+    }
+    const std::string pattern = argv[3];
+    const uint32_t num_rounds = atoi(argv[4]);
+    const uint32_t num_cores = utils::CpuTopology::get().numCpus();
+    const uint32_t max_readers_user = atoi(argv[5]);
+    const uint32_t max_readers = (max_readers_user > 0) ? max_readers_user : num_cores - 1;
+    const uint32_t thread_step = atoi(argv[6]);
+    uint32_t core_id_start = 0;
+    if (argc >= 8) core_id_start = atoi(argv[7]);
+    const uint32_t reader_step = std::max<uint64_t>(1, options.getUint("reader_step", 1));
+    if (max_readers + 1 > num_cores) {
+        std::cerr << "max readers=" << max_readers << " needs more than " << num_cores << " cores" << std::endl;
+        exit(1);
+    }
+    utils::Reporter& reporter = utils::Reporter::get();
+    reporter.open("invalidation_fanout", options);
+    reporter.config("region_kb", region_size);
+    reporter.config("stride", stride);
+    reporter.config("pattern", pattern);
+    reporter.config("rounds", num_rounds);
+    reporter.config("seed", options.getUint("seed", 0));
+    // shared lines
+    utils::MemRegion mem_region(region_size * 1024, region_size * 1024, 4096, stride);
+    mem_region.setSeed(options.getUint("seed", 0));
+    if (pattern == "stride") {
+        mem_region.stride_init();
+    } else if (pattern == "pageRand") {
+        mem_region.page_random_init();
+    } else if (pattern == "allRand") {
+        mem_region.all_random_init();
+    } else {
+        std::cerr << "unknown pattern: " << pattern << std::endl;
+        exit(1);
+    }
+    FanoutSetup setup;
+    setup.mem_region = &mem_region;
+    setup.num_rounds = num_rounds;
+    setup.overhead = utils::rdtscp_overhead();
+    utils::dump_clock_info(std::cout);
+    std::cout << "lines=" << mem_region.numActiveLines()
+              << " rdtscp overhead(tick)=" << setup.overhead << std::endl;
+    utils::end_timer("startup", std::cout);
+    // sweep the sharer count
+    utils::start_timer("all");
+    std::vector<uint32_t> reader_counts;
+    std::vector<std::vector<uint32_t>> placements;
+    std::vector<utils::LogHistogram> hists;
+    uint32_t status = 0;
+    for (uint32_t num_readers = 0; num_readers <= max_readers; num_readers += reader_step) {
+        const uint32_t num_threads = num_readers + 1;
+        pthread_barrier_init(&setup.read_done, NULL, num_threads);
+        pthread_barrier_init(&setup.write_done, NULL, num_threads);
+        const std::vector<uint32_t> core_ids = utils::CpuTopology::get().getPlacement(
+            options.get("placement"), num_threads, thread_step, core_id_start);
+        utils::ThreadHelper<ThreadPacket> threads(core_ids);
+        for (uint32_t i = 0; i < num_threads; ++i) {
+            threads.getPacket(i).setup = &setup;
+        }
+        threads.setRoutine(thread_writer, [](const uint32_t& idx) { return idx == 0; });
+        threads.setRoutine(thread_reader, [](const uint32_t& idx) { return idx > 0; });
+        threads.create();
+        threads.join();
+        pthread_barrier_destroy(&setup.read_done);
+        pthread_barrier_destroy(&setup.write_done);
+        for (uint32_t i = 0; i < num_threads; ++i) {
+            status += threads.getPacket(i).bad_status;
+        }
+        reader_counts.push_back(num_readers);
+        placements.push_back(core_ids);
+        hists.push_back(threads.getPacket(0).hist);
+    }
+    utils::end_timer("all", std::cout);
+    const double ns_per_tick = utils::ns_per_tick();
+    // dump per-write latency vs sharer count
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "write latency(ns), tick(GHz)=" << 1 / ns_per_tick << std::endl;
+    out << std::setw(8) << "readers" << std::setw(10) << "mean" << std::setw(10) << "p50"
+        << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+    for (uint32_t i = 0; i < reader_counts.size(); ++i) {
+        out << std::setw(8) << reader_counts[i]
+            << std::setw(10) << hists[i].getMean() * ns_per_tick
+            << std::setw(10) << hists[i].getPercentile(50) * ns_per_tick
+            << std::setw(10) << hists[i].getPercentile(90) * ns_per_tick
+            << std::setw(10) << hists[i].getPercentile(99) * ns_per_tick
+            << std::setw(10) << hists[i].getMax() * ns_per_tick << std::endl;
+        reporter.add(utils::ResultRecord()
+            .config("readers", reader_counts[i]).config("cores", utils::join_list(placements[i]))
+            .metric("writes", hists[i].getCount())
+            .metric("mean_ns", hists[i].getMean() * ns_per_tick)
+            .metric("p50_ns", hists[i].getPercentile(50) * ns_per_tick)
+            .metric("p90_ns", hists[i].getPercentile(90) * ns_per_tick)
+            .metric("p99_ns", hists[i].getPercentile(99) * ns_per_tick)
+            .metric("max_ns", hists[i].getMax() * ns_per_tick));
+    }
+    std::cout << out.str();
+    return status;
+}
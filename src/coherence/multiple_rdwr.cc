@@ -1,12 +1,74 @@
+#include <algorithm>
 #include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <map>
 #include <sstream>
+#include <vector>
+#include <numa.h>
 #include <pthread.h>
-#include <sys/sysinfo.h>
 
 #include "utils/lib_timing.hh"
+#include "utils/lib_options.hh"
+#include "utils/lib_report.hh"
+#include "utils/lib_stats.hh"
 #include "coherence/multiple_rdwr.hh"
 
+// wait for the partition token; returns the release time of the previous holder
+uint64_t acquire_token(ThreadPacket* pkt, const uint32_t& part_idx)
+{
+    switch (pkt->getHandoff()) {
+    case Handoff::SPIN: {
+        FlowLine& step = pkt->getFlowLine(part_idx, MemRegionExt::SPIN_STEP);
+        while (step.value.load(std::memory_order_acquire) != pkt->getThreadId()) {
+            utils::cpu_relax();
+        }
+        return step.release_ns.load(std::memory_order_relaxed);
+    }
+    case Handoff::TICKET: {
+        FlowLine& next = pkt->getFlowLine(part_idx, MemRegionExt::TICKET_NEXT);
+        FlowLine& serving = pkt->getFlowLine(part_idx, MemRegionExt::TICKET_SERVING);
+        const uint32_t ticket = next.value.fetch_add(1, std::memory_order_relaxed);
+        while (serving.value.load(std::memory_order_acquire) != ticket) {
+            utils::cpu_relax();
+        }
+        return serving.release_ns.load(std::memory_order_relaxed);
+    }
+    default: {
+        pthread_mutex_lock(pkt->getFlowMutex(part_idx));
+        while (pkt->getFlowStep(part_idx) != pkt->getThreadId()) {
+            pthread_cond_wait(pkt->getFlowCond(part_idx), pkt->getFlowMutex(part_idx));
+        }
+        return pkt->getFlowLine(part_idx, MemRegionExt::SPIN_STEP).release_ns.load(std::memory_order_relaxed);
+    }
+    }
+}
+
+// pass the partition token on, stamping the release time
+void release_token(ThreadPacket* pkt, const uint32_t& part_idx)
+{
+    switch (pkt->getHandoff()) {
+    case Handoff::SPIN: {
+        FlowLine& step = pkt->getFlowLine(part_idx, MemRegionExt::SPIN_STEP);
+        step.release_ns.store(now_ns(), std::memory_order_relaxed);
+        step.value.store((pkt->getThreadId() + 1) % pkt->getNumThreads(), std::memory_order_release);
+        break;
+    }
+    case Handoff::TICKET: {
+        FlowLine& serving = pkt->getFlowLine(part_idx, MemRegionExt::TICKET_SERVING);
+        serving.release_ns.store(now_ns(), std::memory_order_relaxed);
+        serving.value.store(serving.value.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        break;
+    }
+    default:
+        pkt->getFlowLine(part_idx, MemRegionExt::SPIN_STEP).release_ns.store(now_ns(), std::memory_order_relaxed);
+        pkt->incrFlowStep(part_idx);
+        pthread_cond_broadcast(pkt->getFlowCond(part_idx));
+        pthread_mutex_unlock(pkt->getFlowMutex(part_idx));
+        break;
+    }
+}
+
 // read-modify-write thread
 void *thread_rmw(void *ptr)
 {
@@ -15,21 +77,23 @@ void *thread_rmw(void *ptr)
     // pointer chasing
     register char** p = NULL;
     register char** p2 = NULL;
-    register uint32_t k = 0;
+    register uint64_t k = 0;
+    pkt->startPerf();
     // loop iterations, loop partitions
     for (uint32_t i = 0; i < pkt->getNumIterations(); ++i) {
         for (uint32_t part_idx = 0; part_idx < pkt->getNumPartitions(); ++part_idx) {
             // locking
-            pthread_mutex_lock(pkt->getFlowMutex(part_idx));
-            while (pkt->getFlowStep(part_idx) != pkt->getThreadId()) {
-                pthread_cond_wait(pkt->getFlowCond(part_idx), pkt->getFlowMutex(part_idx));
-            }
-            // per-thread work timer
+            const uint64_t wait_ns = now_ns();
+            const uint64_t release_ns = acquire_token(pkt, part_idx);
+            // handoff latency counts from whichever came later, the release
+            // or our arrival, so neither the previous holder's work nor ours
+            // is included; kept out of the work timer
             if (i > 0 && pkt->isTimerEnabled()) {
+                pkt->addHandoff(now_ns() - std::max(wait_ns, release_ns));
                 pkt->startTimer();
             }
             // real work
-            const uint32_t& num_chases = pkt->getNumLines();
+            const uint64_t num_chases = pkt->getNumLines();
             p = pkt->getStartPoint(part_idx);
             if (pkt->isReadOnly()) {
                 for (k = 0; k < num_chases; ++k) {
@@ -54,20 +118,92 @@ void *thread_rmw(void *ptr)
                 pkt->endTimer();
             }
             // unlocking
-            pkt->incrFlowStep(part_idx);
-            pthread_cond_broadcast(pkt->getFlowCond(part_idx));
-            pthread_mutex_unlock(pkt->getFlowMutex(part_idx));
+            release_token(pkt, part_idx);
             // return something
             bad_status += (p == NULL);
         }
     }
+    pkt->stopPerf();
+    if (pkt->isTimerEnabled()) {
+        pkt->endTimedPhase();
+    }
     pkt->setBadStatus(bad_status);
     return NULL;
 }
 
+// warmup & measurement as phases of one thread pool, so that all threads
+// start together; the measurement is repeated as the repeat config asks;
+// returns the # of threads with bad status
+uint32_t run_threads(
+    const MemSetup::Handle& mem_setup, const std::vector<uint32_t>& core_ids,
+    Handoff handoff, bool perf, const utils::RepeatConfig& repeat, double& per_ref_ns)
+{
+    const uint32_t num_threads = core_ids.size();
+    utils::ThreadHelper<ThreadPacket> threads(core_ids);
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        threads.getPacket(i).setMemSetup(mem_setup);
+        threads.getPacket(i).setHandoff(handoff);
+        threads.getPacket(i).setPerfEnabled(perf);
+        //if (i % 2 == 1) {
+        //    threads.getPacket(i).setReadOnly(true);
+        //}
+        threads.getPacket(i).setDualStream(true);
+    }
+    threads.setRoutine(thread_rmw, [](const uint32_t& idx) { return true; });
+    threads.startPool();
+    // warmup
+    utils::start_timer("warmup");
+    threads.runPhase();
+    utils::end_timer("warmup", std::cout);
+    // main measurement
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        threads.getPacket(i).setTimerEnabled();
+    }
+    utils::start_timer("all");
+    utils::Repeater repeater(repeat);
+    const utils::SampleStats stats = repeater.collect([&threads, &num_threads]() -> double {
+        threads.runPhase();
+        double sample_ns = 0;
+        for (uint32_t i = 0; i < num_threads; ++i) {
+            sample_ns += threads.getPacket(i).takePerRefNs() / num_threads;
+        }
+        return sample_ns;
+    });
+    utils::end_timer("all", std::cout);
+    threads.stopPool();
+    // check output & dump timers
+    std::vector<std::string> phases = {"warmup"};
+    for (uint32_t i = 0; i < repeater.getSamples().size(); ++i) {
+        phases.push_back(repeat.isRepeated() ? "main" + std::to_string(i) : "main");
+    }
+    uint32_t status = 0;
+    double handoff_ns = 0;
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        ThreadPacket& pkt = threads.getPacket(i);
+        status += pkt.getBadStatus();
+        pkt.dumpTimer(std::cout);
+        pkt.dumpPerf(std::cout, phases);
+        handoff_ns += pkt.getHandoffLatency() / num_threads;
+        utils::Reporter::get().add(utils::ResultRecord()
+            .config("scope", "thread").config("thread", i).config("core", pkt.getCoreId())
+            .metric("per_ref_ns", pkt.getPerRefNs()).metric("handoff_ns", pkt.getHandoffLatency()));
+    }
+    utils::ResultRecord record;
+    record.config("scope", "aggregate").config("cores", utils::join_list(core_ids))
+        .metric("per_ref_ns", stats.mean).metric("handoff_ns", handoff_ns);
+    if (repeat.isRepeated()) {
+        utils::dump_stats(std::cout, "all", "per-ref(ns)", stats);
+        record.stats("per_ref_ns", stats);
+    }
+    utils::Reporter::get().add(record);
+    per_ref_ns = stats.mean;
+    return status;
+}
+
 int main(int argc, char** argv)
 {
     utils::start_timer("startup");
+    const utils::Options options(argc, argv);
     // input parameters
     if (argc < 9) {
         std::cout << "Usage: ./multiple_rdwr"
@@ -79,54 +215,140 @@ int main(int argc, char** argv)
         std::cout << "\tpattern: stride, pageRand, allRand" << std::endl;
         std::cout << "\tthread mapping step: e.g. 2 leads to 0,1,2,3 -> 0,2,1,3" << std::endl;
         std::cout << "\tsame # iterations for both warmup and main measurement" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "\t--handoff=condvar|spin|ticket: how the partition token is passed (default condvar)" << std::endl;
+        std::cout << "\t\tspin: round-robin step on its own line; ticket: FIFO ticket counter" << std::endl;
+        std::cout << "\t--placement=compact|scatter|core|l3|<cpu list>: placement from the cpu topology, overrides the mapping step" << std::endl;
+        std::cout << "\t--home=local|interleave|<node>: NUMA node backing the partitions (default local first-touch)" << std::endl;
+        std::cout << "\t--hugepage: back the partitions with hugepages" << std::endl;
+        std::cout << "\t--seed=<S>: seed of the random patterns, partition i uses S+i (default 0)" << std::endl;
+        std::cout << "\t--numa_sweep: threads on each requester node x partitions on each home node" << std::endl;
+        std::cout << "\t--reps=<R>: repeat the main phase R times, print min/median/mean/stddev/95% CI of per-ref" << std::endl;
+        std::cout << "\t--rel_ci=<X>: repeat until the 95% CI is within X of the mean (e.g. 0.01), at least --reps, at most --max_reps (default 100)" << std::endl;
+        std::cout << "\t--outlier=<K>: drop samples beyond K x IQR outside the quartiles, e.g. 1.5; default keep all" << std::endl;
+        std::cout << "\t--perf: hardware counters (software ones if unavailable) over the startup, and per thread over the warmup & main phases" << std::endl;
+        std::cout << "\t--report=<file|->: one structured record per measurement; --report_format=jsonl|csv (default by extension)" << std::endl;
         exit(1);
     }
-    const uint32_t region_size = atoi(argv[1]);
-    const uint32_t page_size = atoi(argv[2]);
-    const uint32_t stride = atoi(argv[3]);
+    const uint64_t region_size = strtoull(argv[1], NULL, 10);
+    const uint64_t page_size = strtoull(argv[2], NULL, 10);
+    const uint64_t stride = strtoull(argv[3], NULL, 10);
     std::string pattern = argv[4];
-    const uint32_t partition_size = atoi(argv[5]);
+    const uint64_t partition_size = strtoull(argv[5], NULL, 10);
     const uint32_t num_iterations = atoi(argv[6]);
     const uint32_t num_threads_user = atoi(argv[7]);
     const uint32_t thread_step = atoi(argv[8]);
     uint32_t core_id_start = 0;
     if (argc >= 10) core_id_start = atoi(argv[9]);
+    utils::PerfGroup perf(options.has("perf"));
+    perf.start();
+    utils::Reporter& reporter = utils::Reporter::get();
+    reporter.open("multiple_rdwr", options);
+    const std::string handoff_str = options.get("handoff", "condvar");
+    Handoff handoff = Handoff::CONDVAR;
+    if (handoff_str == "spin") {
+        handoff = Handoff::SPIN;
+    } else if (handoff_str == "ticket") {
+        handoff = Handoff::TICKET;
+    } else if (handoff_str != "condvar") {
+        std::cerr << "unknown handoff: " << handoff_str << std::endl;
+        exit(1);
+    }
+    // home of the partitions
+    const std::string home = options.get("home", "local");
+    utils::MemType mem_type = utils::MemType::NATIVE;
+    int home_node = -1;
+    if (home == "interleave") {
+        mem_type = utils::MemType::INTERLEAVE;
+    } else if (home != "local") {
+        mem_type = utils::MemType::NODE;
+        const int max_node = (numa_available() < 0) ? 0 : numa_max_node();
+        char* end = NULL;
+        const long node = strtol(home.c_str(), &end, 10);
+        if (end == home.c_str() || *end != '\0' || node < 0 || node > max_node) {
+            std::cerr << "unknown home: " << home << "; expected local, interleave or a node in 0-"
+                      << max_node << std::endl;
+            exit(1);
+        }
+        home_node = node;
+    }
+    const bool use_hugepage = options.has("hugepage");
+    const uint64_t seed = options.getUint("seed", 0);
+    reporter.config("region_kb", region_size);
+    reporter.config("page_kb", page_size);
+    reporter.config("stride", stride);
+    reporter.config("pattern", pattern);
+    reporter.config("partition_kb", partition_size);
+    reporter.config("iters", num_iterations);
+    reporter.config("handoff", handoff_str);
+    reporter.config("home", home);
+    reporter.config("hugepage", use_hugepage);
+    reporter.config("seed", seed);
+    const utils::RepeatConfig repeat(options);
+    const uint32_t num_cores = utils::CpuTopology::get().numCpus();
+    // requester node x home node sweep
+    if (options.has("numa_sweep")) {
+        if (numa_available() < 0) {
+            std::cerr << "numa is not available" << std::endl;
+            exit(1);
+        }
+        std::vector<int> home_nodes;
+        for (int node = 0; node <= numa_max_node(); ++node) {
+            if (numa_bitmask_isbitset(numa_all_nodes_ptr, node)) {
+                home_nodes.push_back(node);
+            }
+        }
+        // requesters: nodes with cpus we may run on
+        std::map<int, std::vector<uint32_t>> node_cpus;
+        for (const utils::CpuInfo& info : utils::CpuTopology::get().getCpus()) {
+            if (info.node_id >= 0) {
+                node_cpus[info.node_id].push_back(info.cpu);
+            }
+        }
+        utils::end_timer("startup", std::cout);
+        std::ostringstream table;
+        table << std::fixed << std::setprecision(3) << "per-ref(ns), row: requester node, column: home node" << std::endl;
+        table << std::setw(10) << "req\\home";
+        for (const int& node : home_nodes) table << std::setw(12) << node;
+        table << std::endl;
+        uint32_t status = 0;
+        for (const auto& requester : node_cpus) {
+            std::vector<uint32_t> core_ids = requester.second;
+            const uint32_t num_threads = (num_threads_user > 0) ? num_threads_user : core_ids.size();
+            if (core_ids.size() < num_threads) {
+                std::cerr << "node " << requester.first << " has only " << core_ids.size()
+                          << " cpus for " << num_threads << " threads" << std::endl;
+                exit(1);
+            }
+            core_ids.resize(num_threads);
+            table << std::setw(10) << requester.first;
+            for (const int& node : home_nodes) {
+                std::cout << "requester node " << requester.first << ", home node " << node << std::endl;
+                reporter.config("requester_node", requester.first);
+                reporter.config("home", std::to_string(node));
+                MemSetup::Handle mem_setup = std::make_shared<MemSetup>(
+                        region_size, page_size, stride, pattern,
+                        partition_size, num_iterations, utils::MemType::NODE, node, use_hugepage, seed);
+                double per_ref_ns = 0;
+                status += run_threads(mem_setup, core_ids, handoff, options.has("perf"), repeat, per_ref_ns);
+                table << std::setw(12) << per_ref_ns;
+            }
+            table << std::endl;
+        }
+        std::cout << std::endl << table.str() << std::endl;
+        return status;
+    }
     // memory region setup
     MemSetup::Handle mem_setup = std::make_shared<MemSetup>(
             region_size, page_size, stride, pattern,
-            partition_size, num_iterations);
+            partition_size, num_iterations, mem_type, home_node, use_hugepage, seed);
     // thread attrs
-    const uint32_t num_cores = get_nprocs();
     const uint32_t num_threads = (num_threads_user > 0) ? num_threads_user : num_cores;
-    utils::ThreadHelper<ThreadPacket> threads(num_threads, num_cores, thread_step, core_id_start);
-    for (uint32_t i = 0; i < num_threads; ++i) {
-        threads.getPacket(i).setMemSetup(mem_setup);
-        //if (i % 2 == 1) {
-        //    threads.getPacket(i).setReadOnly(true);
-        //}
-        threads.getPacket(i).setDualStream(true);
-    }
+    const std::vector<uint32_t> core_ids = utils::CpuTopology::get().getPlacement(
+        options.get("placement"), num_threads, thread_step, core_id_start);
+    perf.dump(std::cout, "startup", perf.stop());
     utils::end_timer("startup", std::cout);
-    // warmup
-    utils::start_timer("warmup");
-    threads.setRoutine(thread_rmw, [](const uint32_t& idx) { return true; });
-    threads.create();
-    threads.join();
-    utils::end_timer("warmup", std::cout);
-    // main measurement
-    for (uint32_t i = 0; i < num_threads; ++i) {
-        threads.getPacket(i).setTimerEnabled();
-    }
-    utils::start_timer("all");
-    threads.setRoutine(thread_rmw, [](const uint32_t& idx) { return true; });
-    threads.create();
-    threads.join();
-    utils::end_timer("all", std::cout);
-    // check output & dump timers
-    uint32_t status = 0;
-    for (uint32_t i = 0; i < num_threads; ++i) {
-        status += threads.getPacket(i).getBadStatus();
-        threads.getPacket(i).dumpTimer(std::cout);
-    }
+    double per_ref_ns = 0;
+    const uint32_t status = run_threads(mem_setup, core_ids, handoff, options.has("perf"), repeat, per_ref_ns);
     return status;
 }
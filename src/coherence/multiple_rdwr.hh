@@ -1,8 +1,13 @@
 #ifndef __MULTIPLE_RDWR__
 #define __MULTIPLE_RDWR__
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
 #include <memory>
+#include <new>
 #include <string>
 #include <iostream>
 #include <sstream>
@@ -11,20 +16,42 @@
 #include <pthread.h>
 
 #include "utils/lib_mem_region.hh"
+#include "utils/lib_perf.hh"
 #include "utils/lib_timing.hh"
 #include "utils/lib_threading.hh"
 
+// how the per-partition token is passed between threads
+enum class Handoff { CONDVAR, SPIN, TICKET };
+
+static inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// a counter on its own cache line, with the release time of the last holder
+// next to it so the acquirer gets both in one line transfer
+struct FlowLine {
+    std::atomic<uint64_t> release_ns;
+    std::atomic<uint32_t> value;
+    char padding[64 - sizeof(std::atomic<uint64_t>) - sizeof(std::atomic<uint32_t>)];
+};
+static_assert(sizeof(FlowLine) == 64, "FlowLine must fill exactly one cache line");
+
 class MemRegionExt : public utils::MemRegion {
   public:
     using Handle = std::shared_ptr<MemRegionExt>;
 
     MemRegionExt(
-        uint32_t region_size,
-        uint32_t page_size,
-        uint32_t line_size,
+        uint64_t region_size,
+        uint64_t page_size,
+        uint64_t line_size,
         bool use_hugepage,
-        uint32_t num_partitions) :
-        utils::MemRegion(region_size, region_size, page_size, line_size, use_hugepage)
+        uint32_t num_partitions,
+        utils::MemType mem_type=utils::MemType::NATIVE,
+        int numa_node=-1) :
+        // non-native memory goes entirely into region-2
+        utils::MemRegion(region_size, region_size, page_size, line_size, use_hugepage,
+                         mem_type, (mem_type == utils::MemType::NATIVE) ? 0 : region_size, numa_node)
     {
         flow_mutex.reset(new pthread_mutex_t);
         flow_cond.reset(new pthread_cond_t);
@@ -32,15 +59,34 @@ class MemRegionExt : public utils::MemRegion {
         pthread_mutex_init(flow_mutex.get(), NULL);
         pthread_cond_init(flow_cond.get(), NULL);
         *flow_step = 0;
+        // spin step, next ticket, now serving
+        void* lines = NULL;
+        if (posix_memalign(&lines, 64, NUM_FLOW_LINES * sizeof(FlowLine)) != 0) {
+            std::cerr << "failed to allocate flow lines" << std::endl;
+            exit(1);
+        }
+        flow_lines = static_cast<FlowLine*>(lines);
+        for (uint32_t i = 0; i < NUM_FLOW_LINES; ++i) {
+            new (&flow_lines[i]) FlowLine();
+            flow_lines[i].value.store(0);
+            flow_lines[i].release_ns.store(0);
+        }
     }
     ~MemRegionExt() {
         pthread_mutex_destroy(flow_mutex.get());
         pthread_cond_destroy(flow_cond.get());
+        free(flow_lines);
     }
 
+    static const uint32_t NUM_FLOW_LINES = 3;
+    static const uint32_t SPIN_STEP = 0;
+    static const uint32_t TICKET_NEXT = 1;
+    static const uint32_t TICKET_SERVING = 2;
+
     std::unique_ptr<pthread_mutex_t> flow_mutex;
     std::unique_ptr<pthread_cond_t>  flow_cond;
     std::unique_ptr<uint32_t>        flow_step;
+    FlowLine*                        flow_lines;
 };
 
 class MemSetup {
@@ -48,12 +94,16 @@ class MemSetup {
     using Handle = std::shared_ptr<MemSetup>;
 
     MemSetup(
-            uint32_t region_size,
-            uint32_t page_size,
-            uint32_t stride,
+            uint64_t region_size,
+            uint64_t page_size,
+            uint64_t stride,
             std::string pattern,
-            uint32_t partition_size,
-            uint32_t num_iterations) :
+            uint64_t partition_size,
+            uint32_t num_iterations,
+            utils::MemType mem_type=utils::MemType::NATIVE,
+            int numa_node=-1,
+            bool use_hugepage=false,
+            uint64_t seed=0) :
         region_size_ (region_size),
         partition_size_ (partition_size),
         num_partitions_ (region_size / partition_size),
@@ -61,10 +111,11 @@ class MemSetup {
         num_iterations_ (num_iterations)
     {
         for (uint32_t i = 0; i < mem_regions_.size(); ++i) {
-            const bool use_hugepage = false;
             mem_regions_[i] = std::make_shared<MemRegionExt>(
                 1024*partition_size, 1024*page_size, stride, use_hugepage,
-                num_partitions_);
+                num_partitions_, mem_type, numa_node);
+            // every partition gets its own random order
+            mem_regions_[i]->setSeed(seed + i);
             if (pattern == "stride") {
                 mem_regions_[i]->stride_init();
             } else if (pattern == "pageRand") {
@@ -80,8 +131,8 @@ class MemSetup {
     ~MemSetup() = default;
 
   private:
-    const uint32_t region_size_;
-    const uint32_t partition_size_;
+    const uint64_t region_size_;
+    const uint64_t partition_size_;
     const uint32_t num_partitions_;
     std::vector<MemRegionExt::Handle> mem_regions_;
     const uint32_t num_iterations_;
@@ -96,7 +147,10 @@ class ThreadPacket: public utils::BaseThreadPacket {
         mem_setup_ (nullptr),
         bad_status_ (false),
         read_only_ (false),
-        timer_enabled_ (false)
+        timer_enabled_ (false),
+        handoff_ (Handoff::CONDVAR),
+        handoff_ns_ (0),
+        num_handoffs_ (0)
     { }
     ~ThreadPacket() = default;
 
@@ -104,7 +158,18 @@ class ThreadPacket: public utils::BaseThreadPacket {
 
     uint32_t getNumIterations() const { return mem_setup_->num_iterations_; }
     uint32_t getNumPartitions() const { return mem_setup_->num_partitions_; }
-    uint32_t getNumLines() const { return mem_setup_->mem_regions_[0]->numActiveLines(); }
+    uint64_t getNumLines() const { return mem_setup_->mem_regions_[0]->numActiveLines(); }
+    // averaged over the timed phases
+    double getPerRefNs() const {
+        return timer_.getElapsedTime()*1e9/getNumLines()/(getNumIterations()-1)/std::max<uint32_t>(1, num_timed_phases_);
+    }
+    // per-ref time of the timed phases since the last call
+    double takePerRefNs() {
+        const double elapsed_time = timer_.getElapsedTime() - taken_time_;
+        taken_time_ = timer_.getElapsedTime();
+        return elapsed_time*1e9/getNumLines()/(getNumIterations()-1);
+    }
+    void endTimedPhase() { ++ num_timed_phases_; }
     char** getStartPoint(const uint32_t& part_idx) const {
         return mem_setup_->mem_regions_[part_idx]->getStartPoint();
     }
@@ -118,6 +183,9 @@ class ThreadPacket: public utils::BaseThreadPacket {
     void incrFlowStep(const uint32_t& part_idx) {
         *(mem_setup_->mem_regions_[part_idx]->flow_step) = (*(mem_setup_->mem_regions_[part_idx]->flow_step) + 1) % getNumThreads();
     }
+    FlowLine& getFlowLine(const uint32_t& part_idx, uint32_t line_idx) {
+        return mem_setup_->mem_regions_[part_idx]->flow_lines[line_idx];
+    }
 
     void setBadStatus(uint32_t v) { bad_status_ = v; }
     uint32_t getBadStatus() const { return bad_status_; }
@@ -127,9 +195,14 @@ class ThreadPacket: public utils::BaseThreadPacket {
     void dumpTimer(std::ostream& os) {
         std::string out_str = "timer <" + getSignature() + "> elapsed:" +
             " total(s)=" + std::to_string(timer_.getElapsedTime()) +
-            " per-ref(ns)=" + std::to_string(timer_.getElapsedTime()*1e9/getNumLines()/(getNumIterations()-1)) + "\n";
+            " per-ref(ns)=" + std::to_string(getPerRefNs()) +
+            " handoff(ns)=" + std::to_string(getHandoffLatency()) +
+            " window(us)=[" + std::to_string(getPhaseBegin()*1e6) + "," + std::to_string(getPhaseEnd()*1e6) + "]\n";
         os << out_str;
     }
+    // time from the previous holder's release to our acquire
+    void addHandoff(uint64_t ns) { handoff_ns_ += ns; ++ num_handoffs_; }
+    double getHandoffLatency() const { return (num_handoffs_ > 0) ? (double)handoff_ns_ / num_handoffs_ : 0; }
 
     // pattern
     void setReadOnly(bool v) { read_only_ = v; }
@@ -139,6 +212,22 @@ class ThreadPacket: public utils::BaseThreadPacket {
     // timer control
     void setTimerEnabled(bool v = true) { timer_enabled_ = v; }
     const bool& isTimerEnabled() const { return timer_enabled_; }
+    // handoff mechanism
+    void setHandoff(Handoff v) { handoff_ = v; }
+    const Handoff& getHandoff() const { return handoff_; }
+    // counters per phase; opened by the pool thread itself, so they count it
+    void setPerfEnabled(bool v = true) { perf_enabled_ = v; }
+    void startPerf() {
+        if (!perf_) perf_.reset(new utils::PerfGroup(perf_enabled_));
+        perf_->start();
+    }
+    void stopPerf() { perf_counts_.push_back(perf_->stop()); }
+    void dumpPerf(std::ostream& os, const std::vector<std::string>& phases) const {
+        const uint64_t num_refs = getNumLines() * getNumPartitions() * getNumIterations();
+        for (uint32_t i = 0; i < phases.size() && i < perf_counts_.size(); ++i) {
+            perf_->dump(os, phases[i] + "/" + getSignature(), perf_counts_[i], num_refs);
+        }
+    }
 
   private:
     MemSetup::Handle mem_setup_;
@@ -147,18 +236,26 @@ class ThreadPacket: public utils::BaseThreadPacket {
     bool read_only_ = false;
     bool dual_stream_ = false;
     bool timer_enabled_ = false;
+    Handoff handoff_;
+    uint64_t handoff_ns_;
+    uint64_t num_handoffs_;
+    uint32_t num_timed_phases_ = 0;
+    double taken_time_ = 0;
+    bool perf_enabled_ = false;
+    std::unique_ptr<utils::PerfGroup> perf_;
+    std::vector<std::vector<double>> perf_counts_;
 };
 
 bool warm_up(void *ptr, std::string post_fix = "")
 {
     const ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
     register char** p = NULL;
-    register uint32_t k = 0;
+    register uint64_t k = 0;
     // start timer
     utils::start_timer("warmup"+post_fix);
     // read-in memory regions
     for (uint32_t part_idx = 0; part_idx < pkt->getNumPartitions(); ++part_idx) {
-        const uint32_t& num_chases = pkt->getNumLines();
+        const uint64_t num_chases = pkt->getNumLines();
         p = pkt->getStartPoint(part_idx);
         for (k = 0; k < num_chases; ++k) {
             p = (char**)(*p);
@@ -2,8 +2,9 @@
 #include <iostream>
 #include <sstream>
 #include <pthread.h>
-#include <sys/sysinfo.h>
 
+#include "utils/lib_options.hh"
+#include "utils/lib_report.hh"
 #include "utils/lib_timing.hh"
 #include "coherence/multiple_rdwr.hh"
 
@@ -16,7 +17,7 @@ void *thread_rmw(void *ptr)
     warm_up(ptr, std::to_string(pkt->getThreadId()));
     // pointer chasing
     register char** p = NULL;
-    register uint32_t k = 0;
+    register uint64_t k = 0;
     // loop iterations, loop partitions
     for (uint32_t i = 0; i < pkt->getNumIterations(); ++i) {
         for (uint32_t part_idx = 0; part_idx < pkt->getNumPartitions(); ++part_idx) {
@@ -25,7 +26,7 @@ void *thread_rmw(void *ptr)
             // per-thread work timer
             pkt->startTimer();
             // real work
-            const uint32_t& num_chases = pkt->getNumLines();
+            const uint64_t num_chases = pkt->getNumLines();
             p = pkt->getStartPoint(part_idx);
             for (k = 0; k < num_chases; ++k) {
                 *(p + 4) += 1;
@@ -45,6 +46,7 @@ void *thread_rmw(void *ptr)
 
 int main(int argc, char** argv)
 {
+    const utils::Options options(argc, argv);
     // input parameters
     if (argc != 9) {
         std::cout << "Usage: ./smt_rdwr"
@@ -54,27 +56,39 @@ int main(int argc, char** argv)
         std::cout << "\tstride (spatial) in B" << std::endl;
         std::cout << "\tpattern: stride, pageRand, allRand" << std::endl;
         std::cout << "\tthread mapping step: e.g. 2 leads to 0,1,2,3 -> 0,2,1,3" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "\t--placement=compact|scatter|core|l3|<cpu list>: placement from the cpu topology, overrides the mapping step" << std::endl;
+        std::cout << "\t--seed=<S>: seed of the random patterns, thread i's region uses S+i (default 0)" << std::endl;
+        std::cout << "\t--report=<file|->: one structured record per measurement; --report_format=jsonl|csv (default by extension)" << std::endl;
         exit(1);
     }
-    const uint32_t region_size = atoi(argv[1]);
-    const uint32_t page_size = atoi(argv[2]);
-    const uint32_t stride = atoi(argv[3]);
+    const uint64_t region_size = strtoull(argv[1], NULL, 10);
+    const uint64_t page_size = strtoull(argv[2], NULL, 10);
+    const uint64_t stride = strtoull(argv[3], NULL, 10);
     std::string pattern0 = argv[4];
     std::string pattern1 = argv[5];
     const uint32_t num_iterations0 = atoi(argv[6]);
     const uint32_t num_iterations1 = atoi(argv[7]);
     const uint32_t thread_step = atoi(argv[8]);
+    utils::Reporter& reporter = utils::Reporter::get();
+    reporter.open("smt_rdwr", options);
+    reporter.config("region_kb", region_size);
+    reporter.config("page_kb", page_size);
+    reporter.config("stride", stride);
+    const uint64_t seed = options.getUint("seed", 0);
+    reporter.config("seed", seed);
     // memory region setup
     MemSetup::Handle mem_setup0 = std::make_shared<MemSetup>(
             region_size, page_size, stride, pattern0,
-            region_size, num_iterations0);
+            region_size, num_iterations0, utils::MemType::NATIVE, -1, false, seed);
     MemSetup::Handle mem_setup1 = std::make_shared<MemSetup>(
             region_size, page_size, stride, pattern1,
-            region_size, num_iterations1);
+            region_size, num_iterations1, utils::MemType::NATIVE, -1, false, seed + 1);
     // thread attrs
-    const uint32_t num_cores = get_nprocs();
     const uint32_t num_threads = 2;
-    utils::ThreadHelper<ThreadPacket> threads(num_threads, num_cores, thread_step);
+    const std::vector<uint32_t> core_ids = utils::CpuTopology::get().getPlacement(
+        options.get("placement"), num_threads, thread_step);
+    utils::ThreadHelper<ThreadPacket> threads(core_ids);
     threads.getPacket(0).setMemSetup(mem_setup0);
     threads.getPacket(1).setMemSetup(mem_setup1);
     utils::start_timer("all");
@@ -86,9 +100,16 @@ int main(int argc, char** argv)
     utils::end_timer("all", std::cout);
     // check output & dump timers
     uint32_t status = 0;
+    const std::string patterns[] = {pattern0, pattern1};
+    const uint32_t iterations[] = {num_iterations0, num_iterations1};
     for (uint32_t i = 0; i < num_threads; ++i) {
-        status += threads.getPacket(i).getBadStatus();
-        threads.getPacket(i).dumpTimer(std::cout);
+        ThreadPacket& pkt = threads.getPacket(i);
+        status += pkt.getBadStatus();
+        pkt.dumpTimer(std::cout);
+        reporter.add(utils::ResultRecord()
+            .config("thread", i).config("core", pkt.getCoreId()).config("cores", utils::join_list(core_ids))
+            .config("pattern", patterns[i]).config("iters", iterations[i])
+            .metric("per_ref_ns", pkt.getPerRefNs()));
     }
     return status;
 }
@@ -0,0 +1,468 @@
+#include <cstdint>
+#include <string>
+#include <immintrin.h>
+
+#include "utils/lib_mem_region.hh"
+#include "lat_bw/bw_kernels.hh"
+
+// throttle the offered load; spins between two unrolled blocks
+static inline void inject_delay(uint64_t delay) {
+    for (uint64_t d = 0; d < delay; ++d) {
+        __asm__ __volatile__("nop");
+    }
+}
+
+template <bool kDelay>
+int benchmark_prd_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register uint64_t* start = (uint64_t*)(mem_region->getStartPoint());
+    register uint64_t* p = start;
+    register uint64_t i = 0;
+    register uint64_t sum = 0;
+#define DOIT(i) p[i]+
+    while (num_iter > 0) {
+        p = start;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            sum +=
+            DOIT(0)  DOIT(4)  DOIT(8)  DOIT(12) DOIT(16) DOIT(20) DOIT(24) DOIT(28)
+            DOIT(32) DOIT(36) DOIT(40) DOIT(44) DOIT(48) DOIT(52) DOIT(56) DOIT(60)
+            DOIT(64) DOIT(68) DOIT(72) DOIT(76) DOIT(80) DOIT(84) DOIT(88) DOIT(92)
+            DOIT(96) DOIT(100) DOIT(104) DOIT(108) DOIT(112) DOIT(116) DOIT(120) p[124];
+            p += 128;
+            if (kDelay) inject_delay(delay);
+        }
+    }
+#undef DOIT
+    return sum;
+}
+
+template <bool kDelay>
+int benchmark_pwr_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register uint64_t* start = (uint64_t*)(mem_region->getStartPoint());
+    register uint64_t* p = start;
+    register uint64_t i = 0;
+#define DOIT(i) p[i] = 1;
+    while (num_iter > 0) {
+        p = start;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            DOIT(0)  DOIT(4)  DOIT(8)  DOIT(12) DOIT(16) DOIT(20) DOIT(24) DOIT(28)
+            DOIT(32) DOIT(36) DOIT(40) DOIT(44) DOIT(48) DOIT(52) DOIT(56) DOIT(60)
+            DOIT(64) DOIT(68) DOIT(72) DOIT(76) DOIT(80) DOIT(84) DOIT(88) DOIT(92)
+            DOIT(96) DOIT(100) DOIT(104) DOIT(108) DOIT(112) DOIT(116) DOIT(120) DOIT(124);
+            p += 128;
+            if (kDelay) inject_delay(delay);
+        }
+    }
+#undef DOIT
+    return 0;
+}
+
+template <bool kDelay>
+int benchmark_prmw_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register uint64_t* start = (uint64_t*)(mem_region->getStartPoint());
+    register uint64_t* p = start;
+    register uint64_t i = 0;
+#define DOIT(i) p[i] += 1;
+    while (num_iter > 0) {
+        p = start;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            DOIT(0)  DOIT(4)  DOIT(8)  DOIT(12) DOIT(16) DOIT(20) DOIT(24) DOIT(28)
+            DOIT(32) DOIT(36) DOIT(40) DOIT(44) DOIT(48) DOIT(52) DOIT(56) DOIT(60)
+            DOIT(64) DOIT(68) DOIT(72) DOIT(76) DOIT(80) DOIT(84) DOIT(88) DOIT(92)
+            DOIT(96) DOIT(100) DOIT(104) DOIT(108) DOIT(112) DOIT(116) DOIT(120) DOIT(124);
+            p += 128;
+            if (kDelay) inject_delay(delay);
+        }
+    }
+#undef DOIT
+    return 0;
+}
+
+template <bool kDelay>
+int benchmark_pcp_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register uint64_t* src = (uint64_t*)(mem_region->getStartPoint());
+    register uint64_t* dst = (uint64_t*)(mem_region->getHalfPoint());
+    register uint64_t* p = src;
+    register uint64_t* q = dst;
+    register uint64_t i = 0;
+#define DOIT(i) q[i] = p[i];
+    while (num_iter > 0) {
+        p = src;
+        q = dst;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            DOIT(0)  DOIT(4)  DOIT(8)  DOIT(12) DOIT(16) DOIT(20) DOIT(24) DOIT(28)
+            DOIT(32) DOIT(36) DOIT(40) DOIT(44) DOIT(48) DOIT(52) DOIT(56) DOIT(60)
+            DOIT(64) DOIT(68) DOIT(72) DOIT(76) DOIT(80) DOIT(84) DOIT(88) DOIT(92)
+            DOIT(96) DOIT(100) DOIT(104) DOIT(108) DOIT(112) DOIT(116) DOIT(120) DOIT(124);
+            p += 128;
+            q += 128;
+            if (kDelay) inject_delay(delay);
+        }
+    }
+#undef DOIT
+    return 0;
+}
+
+// full-line kernels touch all 8 words of every line, so every byte moved
+// is also consumed by the core
+#define DOIT8(i) DOIT(i) DOIT(i+1) DOIT(i+2) DOIT(i+3) DOIT(i+4) DOIT(i+5) DOIT(i+6) DOIT(i+7)
+#define DOIT128  DOIT8(0)  DOIT8(8)  DOIT8(16)  DOIT8(24)  DOIT8(32)  DOIT8(40)  DOIT8(48)  DOIT8(56) \
+                 DOIT8(64) DOIT8(72) DOIT8(80)  DOIT8(88)  DOIT8(96)  DOIT8(104) DOIT8(112) DOIT8(120)
+
+template <bool kDelay>
+int benchmark_frd_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register uint64_t* start = (uint64_t*)(mem_region->getStartPoint());
+    register uint64_t* p = start;
+    register uint64_t i = 0;
+    register uint64_t sum = 0;
+#define DOIT(i) p[i]+
+    while (num_iter > 0) {
+        p = start;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            sum += DOIT128 0;
+            p += 128;
+            if (kDelay) inject_delay(delay);
+        }
+    }
+#undef DOIT
+    return sum;
+}
+
+template <bool kDelay>
+int benchmark_fwr_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register uint64_t* start = (uint64_t*)(mem_region->getStartPoint());
+    register uint64_t* p = start;
+    register uint64_t i = 0;
+#define DOIT(i) p[i] = 1;
+    while (num_iter > 0) {
+        p = start;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            DOIT128;
+            p += 128;
+            if (kDelay) inject_delay(delay);
+        }
+    }
+#undef DOIT
+    return 0;
+}
+
+template <bool kDelay>
+int benchmark_frmw_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register uint64_t* start = (uint64_t*)(mem_region->getStartPoint());
+    register uint64_t* p = start;
+    register uint64_t i = 0;
+#define DOIT(i) p[i] += 1;
+    while (num_iter > 0) {
+        p = start;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            DOIT128;
+            p += 128;
+            if (kDelay) inject_delay(delay);
+        }
+    }
+#undef DOIT
+    return 0;
+}
+
+template <bool kDelay>
+int benchmark_fcp_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register uint64_t* src = (uint64_t*)(mem_region->getStartPoint());
+    register uint64_t* dst = (uint64_t*)(mem_region->getHalfPoint());
+    register uint64_t* p = src;
+    register uint64_t* q = dst;
+    register uint64_t i = 0;
+#define DOIT(i) q[i] = p[i];
+    while (num_iter > 0) {
+        p = src;
+        q = dst;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            DOIT128;
+            p += 128;
+            q += 128;
+            if (kDelay) inject_delay(delay);
+        }
+    }
+#undef DOIT
+    return 0;
+}
+
+// non-temporal kernels cover every byte of a line, as partial lines written
+// with streaming stores would be flushed out of the write-combining buffers
+// one chunk at a time; sfence drains them before a pass is considered done
+
+// streaming (movntdqa) loads; only differ from temporal loads on WC memory
+// or on parts that implement a streaming-load buffer for WB memory
+template <bool kDelay>
+__attribute__((target("sse4.1")))
+int benchmark_ntrd_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register __m128i* start = (__m128i*)(mem_region->getStartPoint());
+    register __m128i* p = start;
+    register uint64_t i = 0;
+    __m128i sum = _mm_setzero_si128();
+#define DOIT(i) sum = _mm_add_epi64(sum, _mm_stream_load_si128(p + (i)));
+    while (num_iter > 0) {
+        p = start;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            DOIT8(0)  DOIT8(8)  DOIT8(16) DOIT8(24) DOIT8(32) DOIT8(40) DOIT8(48) DOIT8(56);
+            p += 64;
+            if (kDelay) inject_delay(delay);
+        }
+    }
+#undef DOIT
+    return _mm_cvtsi128_si64(sum);
+}
+
+// streaming (movnti) stores, no read-for-ownership
+template <bool kDelay>
+int benchmark_ntwr_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register long long* start = (long long*)(mem_region->getStartPoint());
+    register long long* p = start;
+    register uint64_t i = 0;
+#define DOIT(i) _mm_stream_si64(p + (i), 1);
+    while (num_iter > 0) {
+        p = start;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            DOIT128;
+            p += 128;
+            if (kDelay) inject_delay(delay);
+        }
+        _mm_sfence();
+    }
+#undef DOIT
+    return 0;
+}
+
+// temporal loads, streaming stores
+template <bool kDelay>
+int benchmark_ntcp_t(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    register long long* src = (long long*)(mem_region->getStartPoint());
+    register long long* dst = (long long*)(mem_region->getHalfPoint());
+    register long long* p = src;
+    register long long* q = dst;
+    register uint64_t i = 0;
+#define DOIT(i) _mm_stream_si64(q + (i), p[i]);
+    while (num_iter > 0) {
+        p = src;
+        q = dst;
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            DOIT128;
+            p += 128;
+            q += 128;
+            if (kDelay) inject_delay(delay);
+        }
+        _mm_sfence();
+    }
+#undef DOIT
+    return 0;
+}
+#undef DOIT128
+#undef DOIT8
+
+// explicitly vectorized kernels touching every byte of every line; one set
+// per vector width, each compiled for its own ISA and picked at runtime;
+// 4 accumulators keep the reads from being bound by the add latency
+#define DEFINE_VEC_KERNELS(ISA, TARGET, BYTES)                                                  \
+typedef long long vec_##ISA##_t __attribute__((vector_size(BYTES)));                           \
+static const uint64_t VEC_PER_LOOP_##ISA = 16 * 64 / BYTES;                                    \
+__attribute__((target(TARGET)))                                                                 \
+int benchmark_vrd_##ISA(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) { \
+    vec_##ISA##_t* start = (vec_##ISA##_t*)(mem_region->getStartPoint());                       \
+    vec_##ISA##_t* p = start;                                                                   \
+    vec_##ISA##_t sum0 = {0}, sum1 = {0}, sum2 = {0}, sum3 = {0};                               \
+    while (num_iter > 0) {                                                                      \
+        p = start;                                                                              \
+        -- num_iter;                                                                            \
+        for (uint64_t i = 0; i < loop_count; ++i) {                                             \
+            for (uint64_t j = 0; j < VEC_PER_LOOP_##ISA; j += 4) {                              \
+                sum0 += p[j]; sum1 += p[j + 1]; sum2 += p[j + 2]; sum3 += p[j + 3];             \
+            }                                                                                   \
+            p += VEC_PER_LOOP_##ISA;                                                            \
+            if (delay > 0) inject_delay(delay);                                                 \
+        }                                                                                       \
+    }                                                                                           \
+    sum0 += sum1 + sum2 + sum3;                                                                 \
+    return sum0[0];                                                                             \
+}                                                                                               \
+__attribute__((target(TARGET)))                                                                 \
+int benchmark_vwr_##ISA(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) { \
+    vec_##ISA##_t* start = (vec_##ISA##_t*)(mem_region->getStartPoint());                       \
+    vec_##ISA##_t* p = start;                                                                   \
+    vec_##ISA##_t one = {0};                                                                    \
+    one += 1;                                                                                   \
+    while (num_iter > 0) {                                                                      \
+        p = start;                                                                              \
+        -- num_iter;                                                                            \
+        for (uint64_t i = 0; i < loop_count; ++i) {                                             \
+            for (uint64_t j = 0; j < VEC_PER_LOOP_##ISA; ++j) {                                 \
+                p[j] = one;                                                                     \
+            }                                                                                   \
+            p += VEC_PER_LOOP_##ISA;                                                            \
+            if (delay > 0) inject_delay(delay);                                                 \
+        }                                                                                       \
+    }                                                                                           \
+    return 0;                                                                                   \
+}                                                                                               \
+__attribute__((target(TARGET)))                                                                 \
+int benchmark_vrmw_##ISA(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) { \
+    vec_##ISA##_t* start = (vec_##ISA##_t*)(mem_region->getStartPoint());                       \
+    vec_##ISA##_t* p = start;                                                                   \
+    while (num_iter > 0) {                                                                      \
+        p = start;                                                                              \
+        -- num_iter;                                                                            \
+        for (uint64_t i = 0; i < loop_count; ++i) {                                             \
+            for (uint64_t j = 0; j < VEC_PER_LOOP_##ISA; ++j) {                                 \
+                p[j] += 1;                                                                      \
+            }                                                                                   \
+            p += VEC_PER_LOOP_##ISA;                                                            \
+            if (delay > 0) inject_delay(delay);                                                 \
+        }                                                                                       \
+    }                                                                                           \
+    return 0;                                                                                   \
+}                                                                                               \
+__attribute__((target(TARGET)))                                                                 \
+int benchmark_vcp_##ISA(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) { \
+    vec_##ISA##_t* src = (vec_##ISA##_t*)(mem_region->getStartPoint());                         \
+    vec_##ISA##_t* dst = (vec_##ISA##_t*)(mem_region->getHalfPoint());                          \
+    vec_##ISA##_t* p = src;                                                                     \
+    vec_##ISA##_t* q = dst;                                                                     \
+    while (num_iter > 0) {                                                                      \
+        p = src;                                                                                \
+        q = dst;                                                                                \
+        -- num_iter;                                                                            \
+        for (uint64_t i = 0; i < loop_count; ++i) {                                             \
+            for (uint64_t j = 0; j < VEC_PER_LOOP_##ISA; ++j) {                                 \
+                q[j] = p[j];                                                                    \
+            }                                                                                   \
+            p += VEC_PER_LOOP_##ISA;                                                            \
+            q += VEC_PER_LOOP_##ISA;                                                            \
+            if (delay > 0) inject_delay(delay);                                                 \
+        }                                                                                       \
+    }                                                                                           \
+    return 0;                                                                                   \
+}
+
+DEFINE_VEC_KERNELS(sse, "sse2", 16)
+DEFINE_VEC_KERNELS(avx2, "avx2", 32)
+DEFINE_VEC_KERNELS(avx512, "avx512f", 64)
+#undef DEFINE_VEC_KERNELS
+
+std::string get_vec_isa(const std::string& isa) {
+    __builtin_cpu_init();
+    if (isa.empty()) {
+        if (__builtin_cpu_supports("avx512f")) return "avx512";
+        if (__builtin_cpu_supports("avx2")) return "avx2";
+        return "sse";
+    }
+    if (isa == "avx512" && __builtin_cpu_supports("avx512f")) return isa;
+    if (isa == "avx2" && __builtin_cpu_supports("avx2")) return isa;
+    if (isa == "sse") return isa;
+    return "";
+}
+
+static BwKernel get_vec_kernel(const std::string& action, const std::string& isa) {
+#define VEC_KERNEL(ACTION, ISA)                                 \
+    if (action == #ACTION && isa == #ISA) return benchmark_##ACTION##_##ISA;
+    VEC_KERNEL(vrd, sse)    VEC_KERNEL(vwr, sse)    VEC_KERNEL(vrmw, sse)    VEC_KERNEL(vcp, sse)
+    VEC_KERNEL(vrd, avx2)   VEC_KERNEL(vwr, avx2)   VEC_KERNEL(vrmw, avx2)   VEC_KERNEL(vcp, avx2)
+    VEC_KERNEL(vrd, avx512) VEC_KERNEL(vwr, avx512) VEC_KERNEL(vrmw, avx512) VEC_KERNEL(vcp, avx512)
+#undef VEC_KERNEL
+    return BwKernel();
+}
+
+int benchmark_prd(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_prd_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_prd_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+int benchmark_pwr(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_pwr_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_pwr_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+int benchmark_prmw(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_prmw_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_prmw_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+int benchmark_pcp(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_pcp_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_pcp_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+int benchmark_frd(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_frd_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_frd_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+int benchmark_fwr(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_fwr_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_fwr_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+int benchmark_frmw(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_frmw_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_frmw_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+int benchmark_fcp(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_fcp_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_fcp_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+int benchmark_ntrd(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_ntrd_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_ntrd_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+int benchmark_ntwr(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_ntwr_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_ntwr_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+int benchmark_ntcp(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay) {
+    return (delay > 0) ? benchmark_ntcp_t<true>(mem_region, loop_count, num_iter, delay)
+                       : benchmark_ntcp_t<false>(mem_region, loop_count, num_iter, 0);
+}
+
+BwKernel get_bw_kernel(const std::string& action, const std::string& isa) {
+    BwKernel func;
+    if (action.size() > 1 && action[0] == 'v') {
+        return get_vec_kernel(action, get_vec_isa(isa));
+    }
+    if (action == "prd") func = benchmark_prd;
+    else if (action == "pwr") func = benchmark_pwr;
+    else if (action == "prmw") func = benchmark_prmw;
+    else if (action == "pcp") func = benchmark_pcp;
+    else if (action == "ntrd" && __builtin_cpu_supports("sse4.1")) func = benchmark_ntrd;
+    else if (action == "ntwr") func = benchmark_ntwr;
+    else if (action == "ntcp") func = benchmark_ntcp;
+    else if (action == "frd") func = benchmark_frd;
+    else if (action == "fwr") func = benchmark_fwr;
+    else if (action == "frmw") func = benchmark_frmw;
+    else if (action == "fcp") func = benchmark_fcp;
+    return func;
+}
+
+std::string get_temporal_action(const std::string& action) {
+    // full-line kernels, so both sides touch every byte
+    if (action == "ntrd") return "frd";
+    if (action == "ntwr") return "fwr";
+    if (action == "ntcp") return "fcp";
+    return "";
+}
+
+double get_consumed_ratio(const std::string& action) {
+    // p* kernels use one 8B word out of every 32B
+    if (action == "prd" || action == "pwr" || action == "prmw" || action == "pcp") return 0.25;
+    return 1.0;
+}
@@ -0,0 +1,38 @@
+#ifndef __BW_KERNELS_HH__
+#define __BW_KERNELS_HH__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "utils/lib_mem_region.hh"
+
+// p* kernels touch one word every 32B, f* kernels every word of a line;
+// each unrolled loop covers 16 lines (1KB); delay > 0 injects a spin of
+// that many iterations after every unrolled loop to throttle the bandwidth
+using BwKernel = std::function<int(const utils::MemRegion::Handle&, uint64_t, uint64_t, uint64_t)>;
+
+int benchmark_prd(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+int benchmark_pwr(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+int benchmark_prmw(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+int benchmark_pcp(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+int benchmark_frd(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+int benchmark_fwr(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+int benchmark_frmw(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+int benchmark_fcp(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+int benchmark_ntrd(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+int benchmark_ntwr(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+int benchmark_ntcp(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter, uint64_t delay);
+
+// vectorized kernels: vrd, vwr, vrmw, vcp at the width of the given ISA
+// (sse, avx2, avx512); empty isa picks the widest one the cpu supports
+std::string get_vec_isa(const std::string& isa="");
+
+// kernel by action name; empty if unknown or unsupported
+BwKernel get_bw_kernel(const std::string& action, const std::string& isa="");
+// fraction of the bytes moved that the kernel actually reads/writes
+double get_consumed_ratio(const std::string& action);
+// full-line temporal counterpart of a non-temporal action; empty if none
+std::string get_temporal_action(const std::string& action);
+
+#endif
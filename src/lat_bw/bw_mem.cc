@@ -1,15 +1,32 @@
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <vector>
 #include <cassert>
 #include <cstdint>
-#include <functional>
+#include <cstdlib>
+#include <numa.h>
+#include <pthread.h>
 
 #include "utils/lib_mem_region.hh"
+#include "utils/lib_options.hh"
+#include "utils/lib_perf.hh"
+#include "utils/lib_report.hh"
+#include "utils/lib_stats.hh"
+#include "utils/lib_threading.hh"
 #include "utils/lib_timing.hh"
+#include "lat_bw/bw_kernels.hh"
 
 void print_usage() {
     std::cout << "[./bw_mem] [total size in KB] [action] [warmup iters] [main iters] [core freq] <region2 type> <region2 size> <active size in KB>" << std::endl;
+    std::cout << "\tcore freq: in GHz, for per-cycle bandwidth; 0 to measure it" << std::endl;
     std::cout << "\tavailable action: prd, pwr, prmw, pcp, frd, fwr, frmw, fcp" << std::endl;
+    std::cout << "\tnon-temporal action: ntrd, ntwr, ntcp; also measures frd, fwr, fcp for comparison" << std::endl;
+    std::cout << "\tvector action: vrd, vwr, vrmw, vcp; full lines at the widest supported vector width" << std::endl;
     std::cout << "\tregion2 type: native, remote, remote1, remote2, device" << std::endl;
     std::cout << "\tregion2 size: subset of total size, in KB" << std::endl;
     std::cout << "\tactive size: subset of total size, in KB" << std::endl;
@@ -17,35 +34,194 @@ void print_usage() {
     std::cout << "Example: ./bw_mem 4096 prd 10 100 2.3 remote 2048" << std::endl;
     std::cout << "Example: ./bw_mem 4096 prd 10 100 2.3 device 2048" << std::endl;
     std::cout << "Example: ./bw_mem 4096 prd 10 100 2.3 native 0 2048" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "\t--threads=<N>: split the sizes into N per-thread slices, each first-touched by its own thread" << std::endl;
+    std::cout << "\t--thread_step=<step> --core_start=<id>: thread mapping as in ThreadHelper" << std::endl;
+    std::cout << "\t--placement=compact|scatter|core|l3|<cpu list>: placement from the cpu topology, overrides the mapping step" << std::endl;
+    std::cout << "\t--isa=<sse|avx2|avx512>: force the vector width of vector actions" << std::endl;
+    std::cout << "\t--reps=<R>: repeat the main phase R times (single thread), print min/median/mean/stddev/95% CI of bw" << std::endl;
+    std::cout << "\t--rel_ci=<X>: repeat until the 95% CI is within X of the mean (e.g. 0.01), at least --reps, at most --max_reps (default 100)" << std::endl;
+    std::cout << "\t--outlier=<K>: drop samples beyond K x IQR outside the quartiles, e.g. 1.5; default keep all" << std::endl;
+    std::cout << "\t--perf: hardware counters (software ones if unavailable) over the startup, warmup & main phases, per thread" << std::endl;
+    std::cout << "\t--report=<file|->: one structured record per measurement; --report_format=jsonl|csv (default by extension)" << std::endl;
+    std::cout << "Example: ./bw_mem 4194304 prd 2 10 2.3 --threads=16 --thread_step=2" << std::endl;
+    std::cout << "Example: ./bw_mem 4096 vrd 10 100 2.3 --isa=avx2" << std::endl;
 }
 
-int benchmark_prd(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter);
-int benchmark_pwr(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter);
-int benchmark_prmw(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter);
-int benchmark_pcp(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter);
-//int benchmark_frd(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter);
-//int benchmark_fwr(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter);
-//int benchmark_frmw(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter);
-//int benchmark_fcp(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter);
+// same format as utils::end_timer
+void print_bw(std::ostream& os, double bw_bps, float core_freq_ghz) {
+    std::string out_str = "bw(MBpS)=" + std::to_string(bw_bps / 1024 / 1024);
+    out_str += ", bw(BytesPerNs)=" + std::to_string(bw_bps / 1000000000);
+    out_str += ", bw(BytesPerCycle)=" + std::to_string(bw_bps / 1000000000 / core_freq_ghz);
+    out_str += "\n\n";
+    os << out_str;
+}
+
+// bytes the memory system moved vs. bytes the core actually used
+void print_consumed(std::ostream& os, const std::string& action, double bytes, double elapsed_time) {
+    const double consumed = bytes * get_consumed_ratio(action);
+    std::string out_str = "moved(MB)=" + std::to_string(bytes / 1024 / 1024);
+    out_str += ", consumed(MB)=" + std::to_string(consumed / 1024 / 1024);
+    out_str += ", consumed bw(MBpS)=" + std::to_string(consumed / elapsed_time / 1024 / 1024);
+    out_str += "\n\n";
+    os << out_str;
+}
+
+// shared by all bandwidth threads
+struct BwSetup {
+    uint64_t region_size;
+    uint64_t active_region_size;
+    uint64_t page_size;
+    uint64_t line_size;
+    bool use_hugepage;
+    utils::MemType region2_type;
+    uint64_t region2_size;
+    BwKernel func;
+    uint64_t loop_count;
+    uint64_t warmup_iteration;
+    uint64_t main_iteration;
+    bool perf;
+    pthread_barrier_t barrier;
+    std::mutex setup_mutex;
+};
+
+class BwThreadPacket : public utils::BaseThreadPacket {
+  public:
+    BwThreadPacket() = default;
+    ~BwThreadPacket() = default;
+
+    BwSetup* setup = nullptr;
+    utils::MemRegion::Handle mem_region;
+    float elapsed_time = 0;
+    int sum = 0;
+    // opened by the thread itself, so it counts that thread
+    std::unique_ptr<utils::PerfGroup> perf;
+    std::vector<double> perf_startup;
+    std::vector<double> perf_warmup;
+    std::vector<double> perf_main;
+};
+
+void *thread_bw(void *ptr)
+{
+    BwThreadPacket* pkt = static_cast<BwThreadPacket*>(ptr);
+    BwSetup* setup = pkt->setup;
+    pkt->perf.reset(new utils::PerfGroup(setup->perf));
+    pkt->perf->start();
+    {
+        // allocated from the pinned thread, so the slice is first-touched on
+        // its node; one at a time to keep the setup log readable
+        std::lock_guard<std::mutex> lock(setup->setup_mutex);
+        pkt->mem_region.reset(new utils::MemRegion(
+            setup->region_size, setup->active_region_size, setup->page_size, setup->line_size,
+            setup->use_hugepage, setup->region2_type, setup->region2_size));
+    }
+    pkt->perf_startup = pkt->perf->stop();
+    pthread_barrier_wait(&setup->barrier);
+    pkt->perf->start();
+    pkt->sum |= setup->func(pkt->mem_region, setup->loop_count, setup->warmup_iteration, 0);
+    pkt->perf_warmup = pkt->perf->stop();
+    // all threads start the measurement together
+    pthread_barrier_wait(&setup->barrier);
+    pkt->perf->start();
+    utils::tsc_start<utils::TSC_MAIN>();
+    pkt->sum |= setup->func(pkt->mem_region, setup->loop_count, setup->main_iteration, 0);
+    pkt->elapsed_time = utils::tsc_stop<utils::TSC_MAIN>() * utils::ns_per_tick() / 1e9;
+    pkt->perf_main = pkt->perf->stop();
+    return NULL;
+}
+
+int run_threads(BwSetup& setup, const utils::Options& options, uint32_t num_threads,
+                uint64_t active_size, float core_freq_ghz, const std::string& action, const std::string& tag)
+{
+    const std::vector<uint32_t> core_ids = utils::CpuTopology::get().getPlacement(
+        options.get("placement"), num_threads, options.getUint("thread_step", 1), options.getUint("core_start", 0));
+    utils::ThreadHelper<BwThreadPacket> threads(core_ids);
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        threads.getPacket(i).setup = &setup;
+    }
+    // workers + main thread
+    pthread_barrier_init(&setup.barrier, NULL, num_threads + 1);
+    threads.setRoutine(thread_bw, [](const uint32_t& idx) { return true; });
+    threads.create();
+    pthread_barrier_wait(&setup.barrier);
+    std::cout << "Memory region setup done; BW test begins ..." << std::endl;
+    std::cout << "Total iterations: " << setup.main_iteration << ", data size per iter per thread: " << active_size << std::endl;
+    utils::end_timer("startup", std::cout);
+    utils::start_timer("warmup");
+    pthread_barrier_wait(&setup.barrier);
+    utils::end_timer("warmup", std::cout);
+    utils::start_timer(tag);
+    threads.join();
+    const double wall_time = utils::end_timer(tag, std::cout);
+    pthread_barrier_destroy(&setup.barrier);
+    // per-thread & aggregate
+    int sum = 0;
+    double sum_bw_bps = 0;
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        const BwThreadPacket& pkt = threads.getPacket(i);
+        const double bw_bps = active_size * setup.main_iteration / pkt.elapsed_time;
+        const int node = (numa_available() < 0) ? 0 : numa_node_of_cpu(pkt.getCoreId());
+        out << "thread <" << pkt.getSignature() << "> node=" << node
+            << " total(s)=" << pkt.elapsed_time
+            << " bw(MBpS)=" << bw_bps / 1024 / 1024
+            << " bw(GBpS)=" << bw_bps / 1000000000 << std::endl;
+        utils::Reporter::get().add(utils::ResultRecord()
+            .config("scope", "thread").config("thread", i).config("core", pkt.getCoreId()).config("node", node)
+            .metric("elapsed_s", pkt.elapsed_time).metric("bw_mbps", bw_bps / 1024 / 1024));
+        sum_bw_bps += bw_bps;
+        sum |= pkt.sum;
+    }
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        const BwThreadPacket& pkt = threads.getPacket(i);
+        pkt.perf->dump(out, "startup/" + pkt.getSignature(), pkt.perf_startup);
+        pkt.perf->dump(out, "warmup/" + pkt.getSignature(), pkt.perf_warmup, active_size / setup.line_size * setup.warmup_iteration);
+        pkt.perf->dump(out, tag + "/" + pkt.getSignature(), pkt.perf_main, active_size / setup.line_size * setup.main_iteration);
+    }
+    // sum of the per-thread rates, and all bytes over the time the slowest thread took
+    const double wall_bw_bps = active_size * setup.main_iteration * num_threads / wall_time;
+    out << "aggregate bw(MBpS)=" << sum_bw_bps / 1024 / 1024
+        << ", bw(GBpS)=" << sum_bw_bps / 1000000000
+        << ", bw(BytesPerCycle)=" << sum_bw_bps / 1000000000 / core_freq_ghz
+        << ", wall bw(GBpS)=" << wall_bw_bps / 1000000000 << std::endl;
+    std::cout << out.str();
+    print_consumed(std::cout, action, active_size * setup.main_iteration * num_threads, wall_time);
+    utils::Reporter::get().add(utils::ResultRecord()
+        .config("scope", "aggregate").config("cores", utils::join_list(core_ids))
+        .metric("elapsed_s", wall_time).metric("bw_mbps", sum_bw_bps / 1024 / 1024)
+        .metric("bw_bytes_per_ns", sum_bw_bps / 1000000000)
+        .metric("bw_bytes_per_cycle", sum_bw_bps / 1000000000 / core_freq_ghz)
+        .metric("wall_bw_mbps", wall_bw_bps / 1024 / 1024)
+        .metric("consumed_bw_mbps", wall_bw_bps * get_consumed_ratio(action) / 1024 / 1024));
+    return sum;
+}
 
 int main(int argc, char **argv)
 {
     utils::start_timer("startup");
+    const utils::Options options(argc, argv);
     if (argc < 6) {
         print_usage();
         return 1;
     }
+    // single-thread only; worker threads open their own
+    utils::PerfGroup perf(options.has("perf") && options.getUint("threads", 1) <= 1);
+    perf.start();
+    utils::Reporter& reporter = utils::Reporter::get();
+    reporter.open("bw_mem", options);
     // get command line arguments
-    uint64_t size = 1024 * static_cast<uint64_t>(atoi(argv[1]));
+    uint64_t size = 1024 * strtoull(argv[1], NULL, 10);
     const std::string action = argv[2];
-    const uint64_t warmup_iteration = atoi(argv[3]);
-    const uint64_t main_iteration = atoi(argv[4]);
-    const float core_freq_ghz = atof(argv[5]);
+    const uint64_t warmup_iteration = strtoull(argv[3], NULL, 10);
+    const uint64_t main_iteration = strtoull(argv[4], NULL, 10);
+    const float core_freq_ghz = utils::resolve_core_freq(atof(argv[5]), std::cout);
     bool use_hugepage = false;
     utils::MemType region2_type = utils::MemType::NATIVE;
     uint64_t region2_size = 0;
+    std::string r2_type_str = "native";
     if (argc >= 8) {
-        const std::string r2_type_str = argv[6];
+        r2_type_str = argv[6];
         if (r2_type_str == "remote" || r2_type_str == "Remote") {
             region2_type = utils::MemType::REMOTE1;
         } else if (r2_type_str == "remote1" || r2_type_str == "Remote1") {
@@ -55,36 +231,77 @@ int main(int argc, char **argv)
         } else if (r2_type_str == "device" || r2_type_str == "Device") {
             region2_type = utils::MemType::DEVICE;
         }
-        region2_size = 1024 * static_cast<uint64_t>(atoi(argv[7]));
+        region2_size = 1024 * strtoull(argv[7], NULL, 10);
     }
     uint64_t active_size = size;
     if (argc >= 9) {
-        active_size = 1024 * static_cast<uint64_t>(atoi(argv[8]));
+        active_size = 1024 * strtoull(argv[8], NULL, 10);
     }
     // action
-    std::function<int(const utils::MemRegion::Handle&, uint64_t, uint64_t)> func;
-    if (action == "prd") func = benchmark_prd;
-    else if (action == "pwr") func = benchmark_pwr;
-    else if (action == "prmw") func = benchmark_prmw;
-    else if (action == "pcp") func = benchmark_pcp;
-//    else if (action == "frd") func = benchmark_frd;
-//    else if (action == "fwr") func = benchmark_fwr;
-//    else if (action == "frmw") func = benchmark_frmw;
-//    else if (action == "fcp") func = benchmark_fcp;
-    else {
+    BwKernel func = get_bw_kernel(action, options.get("isa"));
+    if (!func) {
         print_usage();
         return 1;
     }
+    if (action[0] == 'v') {
+        std::cout << "vector ISA: " << get_vec_isa(options.get("isa")) << std::endl;
+    }
     std::string tag = "bw_mem_" + action;
+    if (action[0] == 'v') {
+        tag += "_" + get_vec_isa(options.get("isa"));
+    }
+    // multiple threads, each over its own slice
+    const uint32_t num_threads = options.getUint("threads", 1);
+    reporter.config("size_kb", size / 1024);
+    reporter.config("action", action);
+    if (action[0] == 'v') {
+        reporter.config("isa", get_vec_isa(options.get("isa")));
+    }
+    reporter.config("warmup_iters", warmup_iteration);
+    reporter.config("main_iters", main_iteration);
+    reporter.config("core_ghz", core_freq_ghz);
+    reporter.config("hugepage", use_hugepage);
+    reporter.config("region2_type", r2_type_str);
+    reporter.config("region2_kb", region2_size / 1024);
+    reporter.config("active_kb", active_size / 1024);
+    reporter.config("threads", std::max<uint32_t>(num_threads, 1));
+    if (num_threads > 1) {
+        if (region2_type == utils::MemType::DEVICE) {
+            std::cerr << "device region cannot be sliced over threads" << std::endl;
+            return 1;
+        }
+        static const uint64_t slice_unit = 4096;
+        size = size / num_threads / slice_unit * slice_unit;
+        active_size = active_size / num_threads / slice_unit * slice_unit;
+        region2_size = region2_size / num_threads / slice_unit * slice_unit;
+        reporter.config("slice_kb", active_size / 1024);
+    }
     // setup memory region
     uint64_t region_size = size;
     uint64_t active_region_size = active_size;
-    if (action == "pcp" or action == "fcp") {
+    if (action == "pcp" or action == "fcp" or action == "ntcp" or action == "vcp") {
         region_size *= 2;
         active_region_size *= 2;
     }
     const uint64_t page_size = 4096;
     const uint64_t line_size = 64;
+    static const uint64_t loop_size = 16 * 64;
+    if (num_threads > 1) {
+        BwSetup setup;
+        setup.region_size = region_size;
+        setup.active_region_size = active_region_size;
+        setup.page_size = page_size;
+        setup.line_size = line_size;
+        setup.use_hugepage = use_hugepage;
+        setup.region2_type = region2_type;
+        setup.region2_size = region2_size;
+        setup.func = func;
+        setup.loop_count = active_size / loop_size;
+        setup.warmup_iteration = warmup_iteration;
+        setup.main_iteration = main_iteration;
+        setup.perf = options.has("perf");
+        return run_threads(setup, options, num_threads, active_size, core_freq_ghz, action, tag);
+    }
     utils::MemRegion::Handle mem_region(
         new utils::MemRegion(
             region_size, active_region_size, page_size, line_size,
@@ -92,107 +309,76 @@ int main(int argc, char **argv)
     // input check
     const uint64_t num_lines = mem_region->numActiveLines();
     // input check
-    static const uint64_t loop_size = 16 * 64;
     assert (active_size % loop_size == 0);
     const uint64_t unrolled_loop_count = active_size / loop_size;
     // run
     std::cout << "Memory region setup done; BW test begins ..." << std::endl;
     std::cout << "Total iterations: " << main_iteration << ", data size per iter: " << active_size << std::endl;
+    perf.dump(std::cout, "startup", perf.stop());
     utils::end_timer("startup", std::cout);
     int sum = 0;
     utils::start_timer("warmup");
+    perf.start();
     // warm-up some iterations
-    sum |= func(mem_region, unrolled_loop_count, warmup_iteration);
+    sum |= func(mem_region, unrolled_loop_count, warmup_iteration, 0);
+    const std::vector<double> warmup_counts = perf.stop();
     utils::end_timer("warmup", std::cout);
+    // per line the kernel touched
+    perf.dump(std::cout, "warmup", warmup_counts, active_size / line_size * warmup_iteration);
     // timer
-    utils::start_timer(tag);
-    sum |= func(mem_region, unrolled_loop_count, main_iteration);
-    utils::end_timer(tag, std::cout, active_size, main_iteration, core_freq_ghz);
-    return sum;
-}
-
-int benchmark_prd(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter) {
-    register uint64_t* start = (uint64_t*)(mem_region->getStartPoint());
-    register uint64_t* p = start;
-    register uint64_t i = 0;
-    register uint64_t sum = 0;
-#define DOIT(i) p[i]+
-    while (num_iter > 0) {
-        p = start;
-        -- num_iter;
-        for (i = 0; i < loop_count; ++i) {
-            sum +=
-            DOIT(0)  DOIT(4)  DOIT(8)  DOIT(12) DOIT(16) DOIT(20) DOIT(24) DOIT(28)
-            DOIT(32) DOIT(36) DOIT(40) DOIT(44) DOIT(48) DOIT(52) DOIT(56) DOIT(60)
-            DOIT(64) DOIT(68) DOIT(72) DOIT(76) DOIT(80) DOIT(84) DOIT(88) DOIT(92)
-            DOIT(96) DOIT(100) DOIT(104) DOIT(108) DOIT(112) DOIT(116) DOIT(120) p[124];
-            p += 128;
-        }
+    const utils::RepeatConfig repeat(options);
+    double elapsed_time = 0;
+    utils::ResultRecord record;
+    if (repeat.isRepeated()) {
+        // main phase repeated, one bandwidth sample each
+        utils::Repeater repeater(repeat);
+        perf.start();
+        const utils::SampleStats stats = repeater.run(
+            [&]() { sum |= func(mem_region, unrolled_loop_count, main_iteration, 0); },
+            [&](double sample_time) { return active_size * main_iteration / sample_time / 1024 / 1024; });
+        const std::vector<double> main_counts = perf.stop();
+        utils::dump_stats(std::cout, tag, "bw(MBpS)", stats);
+        perf.dump(std::cout, tag, main_counts, active_size / line_size * main_iteration * repeater.getSamples().size());
+        // the lines below report the mean, the statistic the CI is about
+        elapsed_time = active_size * main_iteration / (stats.mean * 1024 * 1024);
+        record.stats("bw_mbps", stats);
+    } else {
+        perf.start();
+        utils::tsc_start<utils::TSC_MAIN>();
+        sum |= func(mem_region, unrolled_loop_count, main_iteration, 0);
+        const uint64_t main_ticks = utils::tsc_stop<utils::TSC_MAIN>();
+        const std::vector<double> main_counts = perf.stop();
+        elapsed_time = utils::report_ticks(tag, std::cout, main_ticks);
+        perf.dump(std::cout, tag, main_counts, active_size / line_size * main_iteration);
     }
-#undef DOIT
-    return sum;
-}
-
-int benchmark_pwr(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter) {
-    register uint64_t* start = (uint64_t*)(mem_region->getStartPoint());
-    register uint64_t* p = start;
-    register uint64_t i = 0;
-#define DOIT(i) p[i] = 1;
-    while (num_iter > 0) {
-        p = start;
-        -- num_iter;
-        for (i = 0; i < loop_count; ++i) {
-            DOIT(0)  DOIT(4)  DOIT(8)  DOIT(12) DOIT(16) DOIT(20) DOIT(24) DOIT(28)
-            DOIT(32) DOIT(36) DOIT(40) DOIT(44) DOIT(48) DOIT(52) DOIT(56) DOIT(60)
-            DOIT(64) DOIT(68) DOIT(72) DOIT(76) DOIT(80) DOIT(84) DOIT(88) DOIT(92)
-            DOIT(96) DOIT(100) DOIT(104) DOIT(108) DOIT(112) DOIT(116) DOIT(120) DOIT(124);
-            p += 128;
-        }
-    }
-#undef DOIT
-    return 0;
-}
-
-int benchmark_prmw(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter) {
-    register uint64_t* start = (uint64_t*)(mem_region->getStartPoint());
-    register uint64_t* p = start;
-    register uint64_t i = 0;
-#define DOIT(i) p[i] += 1;
-    while (num_iter > 0) {
-        p = start;
-        -- num_iter;
-        for (i = 0; i < loop_count; ++i) {
-            DOIT(0)  DOIT(4)  DOIT(8)  DOIT(12) DOIT(16) DOIT(20) DOIT(24) DOIT(28)
-            DOIT(32) DOIT(36) DOIT(40) DOIT(44) DOIT(48) DOIT(52) DOIT(56) DOIT(60)
-            DOIT(64) DOIT(68) DOIT(72) DOIT(76) DOIT(80) DOIT(84) DOIT(88) DOIT(92)
-            DOIT(96) DOIT(100) DOIT(104) DOIT(108) DOIT(112) DOIT(116) DOIT(120) DOIT(124);
-            p += 128;
-        }
-    }
-#undef DOIT
-    return 0;
-}
-
-int benchmark_pcp(const utils::MemRegion::Handle& mem_region, uint64_t loop_count, uint64_t num_iter) {
-    register uint64_t* src = (uint64_t*)(mem_region->getStartPoint());
-    register uint64_t* dst = (uint64_t*)(mem_region->getHalfPoint());
-    register uint64_t* p = src;
-    register uint64_t* q = dst;
-    register uint64_t i = 0;
-#define DOIT(i) q[i] = p[i];
-    while (num_iter > 0) {
-        p = src;
-        q = dst;
-        -- num_iter;
-        for (i = 0; i < loop_count; ++i) {
-            DOIT(0)  DOIT(4)  DOIT(8)  DOIT(12) DOIT(16) DOIT(20) DOIT(24) DOIT(28)
-            DOIT(32) DOIT(36) DOIT(40) DOIT(44) DOIT(48) DOIT(52) DOIT(56) DOIT(60)
-            DOIT(64) DOIT(68) DOIT(72) DOIT(76) DOIT(80) DOIT(84) DOIT(88) DOIT(92)
-            DOIT(96) DOIT(100) DOIT(104) DOIT(108) DOIT(112) DOIT(116) DOIT(120) DOIT(124);
-            p += 128;
-            q += 128;
-        }
+    const double bw_bps = active_size * main_iteration / elapsed_time;
+    print_bw(std::cout, bw_bps, core_freq_ghz);
+    print_consumed(std::cout, action, active_size * main_iteration, elapsed_time);
+    reporter.add(record.config("scope", "single")
+        .metric("elapsed_s", elapsed_time).metric("bw_mbps", bw_bps / 1024 / 1024)
+        .metric("bw_bytes_per_ns", bw_bps / 1000000000)
+        .metric("bw_bytes_per_cycle", bw_bps / 1000000000 / core_freq_ghz)
+        .metric("consumed_bw_mbps", bw_bps * get_consumed_ratio(action) / 1024 / 1024));
+    // non-temporal vs. temporal over the same region
+    const std::string temporal_action = get_temporal_action(action);
+    if (!temporal_action.empty()) {
+        const BwKernel temporal_func = get_bw_kernel(temporal_action);
+        const std::string temporal_tag = "bw_mem_" + temporal_action;
+        sum |= temporal_func(mem_region, unrolled_loop_count, warmup_iteration, 0);
+        utils::tsc_start<utils::TSC_MAIN>();
+        sum |= temporal_func(mem_region, unrolled_loop_count, main_iteration, 0);
+        const double temporal_time = utils::report_ticks(temporal_tag, std::cout, utils::tsc_stop<utils::TSC_MAIN>());
+        const double temporal_bw_bps = active_size * main_iteration / temporal_time;
+        print_bw(std::cout, temporal_bw_bps, core_freq_ghz);
+        std::cout << action << " vs. " << temporal_action << ": "
+            << std::fixed << std::setprecision(3) << bw_bps / temporal_bw_bps << "x, "
+            << std::showpos << (bw_bps - temporal_bw_bps) / 1024 / 1024 << std::noshowpos << " MBpS" << std::endl << std::endl;
+        reporter.add(utils::ResultRecord()
+            .config("scope", "single").config("action", temporal_action).config("compared_to", action)
+            .metric("elapsed_s", temporal_time).metric("bw_mbps", temporal_bw_bps / 1024 / 1024)
+            .metric("bw_bytes_per_ns", temporal_bw_bps / 1000000000)
+            .metric("bw_bytes_per_cycle", temporal_bw_bps / 1000000000 / core_freq_ghz)
+            .metric("speedup", bw_bps / temporal_bw_bps));
     }
-#undef DOIT
-    return 0;
+    return sum;
 }
@@ -1,15 +1,32 @@
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
 #include <cassert>
 #include <cstdint>
+#include <cstdlib>
+#include <pthread.h>
 
+#include "utils/lib_histogram.hh"
 #include "utils/lib_mem_region.hh"
+#include "utils/lib_options.hh"
+#include "utils/lib_perf.hh"
+#include "utils/lib_report.hh"
+#include "utils/lib_stats.hh"
+#include "utils/lib_threading.hh"
 #include "utils/lib_timing.hh"
+#include "lat_bw/bw_kernels.hh"
+
+static const uint32_t MAX_NUM_CHAINS = 32;
 
 void print_usage() {
     std::cout << "[./lat_mem_rd] [total size] [page] [stride] [pattern] [warmup iters] [main iters] [core freq] <OS page> <region2 type> <region2 size> <active size>"
               << std::endl;
     std::cout << "\ttotal size & page size in KB; stride size in B" << std::endl;
+    std::cout << "\tcore freq: in GHz, for per-ref cycles; 0 to measure it" << std::endl;
     std::cout << "\tavailable patterns: stride, pageRand, allRand" << std::endl;
     std::cout << "\tOS page: default, hugePage" << std::endl;
     std::cout << "\tregion2 type: native, remote, remote1, remote2, device" << std::endl;
@@ -21,25 +38,239 @@ void print_usage() {
     std::cout << "Example: ./lat_mem_rd 4096 4 64 pageRand 10 100 2.3 default device 2048" << std::endl;
     std::cout << "Example: ./lat_mem_rd 4096 4 64 pageRand 10 100 2.3 default native 0 2048" << std::endl;
     std::cout << "Example: ./lat_mem_rd 4096 4 64 pageRand 10 100 2.3 default remote 4096 2048" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "\t--mlp=<K list>: chase K (1.." << MAX_NUM_CHAINS << ") independent chains in lockstep, e.g. --mlp=1,2,4,8" << std::endl;
+    std::cout << "\t--sweep=<min size in KB>: rebuild the chain over growing active sizes up to active size" << std::endl;
+    std::cout << "\t--sweep_steps=<N>: # of sizes per doubling in sweep mode, default 1" << std::endl;
+    std::cout << "\t--loaded=<N>: chase on thread 0 while N more threads run a bandwidth kernel" << std::endl;
+    std::cout << "\t--load_kernel=<action>: prd, pwr, prmw, pcp; default prd" << std::endl;
+    std::cout << "\t--load_delay=<list>: spins per 1KB of load traffic, one point per delay; default 0" << std::endl;
+    std::cout << "\t--load_size=<KB>: per load-thread region size, default total size" << std::endl;
+    std::cout << "\t--thread_step=<step> --core_start=<id>: thread mapping as in ThreadHelper" << std::endl;
+    std::cout << "\t--placement=compact|scatter|core|l3|<cpu list>: placement from the cpu topology, overrides the mapping step" << std::endl;
+    std::cout << "\t--hist=<N>: time every N-th hop with rdtscp, print latency percentiles & histogram" << std::endl;
+    std::cout << "\t--seed=<S>: seed of the random patterns (default 0)" << std::endl;
+    std::cout << "\t--c2c=<state list>: producer leaves the chain M (dirty), E (clean) or S (shared with a third core)," << std::endl;
+    std::cout << "\t\tthen the consumer chases it; the chain should fit in the producer's cache; stride at least 64" << std::endl;
+    std::cout << "\t--producer=<id> --consumer=<id> --sharer=<id>: cores for c2c mode, default 0, 1, 2" << std::endl;
+    std::cout << "\t--reps=<R>: repeat the main phase R times, print min/median/mean/stddev/95% CI of per-ref" << std::endl;
+    std::cout << "\t--rel_ci=<X>: repeat until the 95% CI is within X of the mean (e.g. 0.01), at least --reps, at most --max_reps (default 100)" << std::endl;
+    std::cout << "\t--outlier=<K>: drop samples beyond K x IQR outside the quartiles, e.g. 1.5; default keep all" << std::endl;
+    std::cout << "\t--perf: hardware counters (software ones if unavailable) over the startup, warmup & main phases" << std::endl;
+    std::cout << "\t--report=<file|->: one structured record per measurement; --report_format=jsonl|csv (default by extension)" << std::endl;
+    std::cout << "Example: ./lat_mem_rd 1048576 4 64 allRand 1 4 2.3 --mlp=1,2,4,8,16,32" << std::endl;
+    std::cout << "Example: ./lat_mem_rd 1048576 4 64 allRand 1 4 2.3 --sweep=16 --sweep_steps=2" << std::endl;
+    std::cout << "Example: ./lat_mem_rd 1048576 4 64 allRand 1 4 2.3 --loaded=7 --load_delay=0,100,400,1600" << std::endl;
+    std::cout << "Example: ./lat_mem_rd 1048576 4 64 allRand 1 4 2.3 default remote 524288 --hist=16" << std::endl;
+    std::cout << "Example: ./lat_mem_rd 256 4 64 allRand 10 100 2.3 --c2c=M,E,S --producer=0 --consumer=8 --sharer=1" << std::endl;
 }
 
 bool benchmark_loads(const utils::MemRegion::Handle &mem_region, uint64_t loop_count, uint64_t num_iter);
+bool benchmark_mlp_loads(const utils::MemRegion::Handle &mem_region, uint64_t loop_count, uint64_t num_iter);
+bool benchmark_sampled_loads(
+    const utils::MemRegion::Handle &mem_region, uint64_t num_chases, uint64_t num_iter,
+    uint64_t sample_every, uint64_t overhead, utils::LogHistogram& hist);
+
+// shared by the chasing thread and the load threads of one loaded-latency point
+struct LoadedLatencySetup {
+    utils::MemRegion::Handle mem_region;
+    uint64_t loop_count = 0;
+    uint64_t warmup_iteration = 0;
+    uint64_t main_iteration = 0;
+    BwKernel load_kernel;
+    uint64_t load_delay = 0;
+    std::atomic<uint32_t> num_loads_started;
+    std::atomic<bool> stop;
+};
+
+class LoadedThreadPacket : public utils::BaseThreadPacket {
+  public:
+    LoadedThreadPacket() = default;
+    ~LoadedThreadPacket() = default;
+
+    LoadedLatencySetup* setup = nullptr;
+    // private region of a load thread
+    utils::MemRegion::Handle load_region;
+    uint64_t load_size = 0;
+    uint64_t load_loop_count = 0;
+    // results
+    uint64_t bytes = 0;
+    float elapsed_time = 0;
+    bool error = false;
+};
+
+// thread 0: pointer chasing once all load threads are running
+void *thread_chase(void *ptr)
+{
+    LoadedThreadPacket* pkt = static_cast<LoadedThreadPacket*>(ptr);
+    LoadedLatencySetup* setup = pkt->setup;
+    while (setup->num_loads_started.load() < pkt->getNumThreads() - 1) { }
+    pkt->error |= benchmark_loads(setup->mem_region, setup->loop_count, setup->warmup_iteration);
+    utils::Timer timer;
+    timer.startTimer();
+    pkt->error |= benchmark_loads(setup->mem_region, setup->loop_count, setup->main_iteration);
+    timer.endTimer();
+    pkt->elapsed_time = timer.getElapsedTime();
+    setup->stop.store(true);
+    return NULL;
+}
+
+// other threads: bandwidth kernel over a private region until the chase is done
+void *thread_load(void *ptr)
+{
+    LoadedThreadPacket* pkt = static_cast<LoadedThreadPacket*>(ptr);
+    LoadedLatencySetup* setup = pkt->setup;
+    uint64_t num_passes = 0;
+    utils::Timer timer;
+    ++ setup->num_loads_started;
+    timer.startTimer();
+    while (!setup->stop.load(std::memory_order_relaxed)) {
+        setup->load_kernel(pkt->load_region, pkt->load_loop_count, 1, setup->load_delay);
+        ++ num_passes;
+    }
+    timer.endTimer();
+    pkt->bytes = num_passes * pkt->load_size;
+    pkt->elapsed_time = timer.getElapsedTime();
+    return NULL;
+}
+
+// cache-to-cache transfer: the producer (thread 0) leaves the chain in a given
+// coherence state, the consumer (thread 1) chases it, the sharer (thread 2)
+// holds a second copy for S
+enum class LineState { M, E, S };
+
+struct C2cSetup {
+    utils::MemRegion::Handle mem_region;
+    uint64_t loop_count = 0;
+    uint64_t warmup_iteration = 0;
+    uint64_t main_iteration = 0;
+    LineState state = LineState::M;
+    pthread_barrier_t barrier;
+};
+
+class C2cThreadPacket : public utils::BaseThreadPacket {
+  public:
+    C2cThreadPacket() = default;
+    ~C2cThreadPacket() = default;
+
+    C2cSetup* setup = nullptr;
+    float elapsed_time = 0;
+    bool error = false;
+};
+
+// read every line of the chain, optionally dirtying it
+bool touch_chain(const utils::MemRegion::Handle& mem_region, bool dirty, bool flush)
+{
+    const uint64_t num_lines = mem_region->numActiveLines();
+    char** p = mem_region->getStartPoint();
+    for (uint64_t k = 0; k < num_lines; ++k) {
+        char** next = (char**)(*p);
+        if (flush) {
+            __asm__ __volatile__("clflush (%0)" :: "r" (p) : "memory");
+        } else if (dirty) {
+            *(volatile uint64_t*)(p + 4) = k;
+        }
+        p = next;
+    }
+    __asm__ __volatile__("mfence" ::: "memory");
+    return (p == NULL);
+}
+
+void *thread_c2c_producer(void *ptr)
+{
+    C2cThreadPacket* pkt = static_cast<C2cThreadPacket*>(ptr);
+    C2cSetup* setup = pkt->setup;
+    for (uint64_t i = 0; i < setup->warmup_iteration + setup->main_iteration; ++i) {
+        // drop all copies, then own the lines: M by writing, E/S by reading
+        pkt->error |= touch_chain(setup->mem_region, false, true);
+        pkt->error |= touch_chain(setup->mem_region, setup->state == LineState::M, false);
+        pthread_barrier_wait(&setup->barrier);
+        pthread_barrier_wait(&setup->barrier);
+        pthread_barrier_wait(&setup->barrier);
+    }
+    return NULL;
+}
+
+void *thread_c2c_sharer(void *ptr)
+{
+    C2cThreadPacket* pkt = static_cast<C2cThreadPacket*>(ptr);
+    C2cSetup* setup = pkt->setup;
+    for (uint64_t i = 0; i < setup->warmup_iteration + setup->main_iteration; ++i) {
+        pthread_barrier_wait(&setup->barrier);
+        if (setup->state == LineState::S) {
+            pkt->error |= touch_chain(setup->mem_region, false, false);
+        }
+        pthread_barrier_wait(&setup->barrier);
+        pthread_barrier_wait(&setup->barrier);
+    }
+    return NULL;
+}
+
+void *thread_c2c_consumer(void *ptr)
+{
+    C2cThreadPacket* pkt = static_cast<C2cThreadPacket*>(ptr);
+    C2cSetup* setup = pkt->setup;
+    uint64_t main_ticks = 0;
+    for (uint64_t i = 0; i < setup->warmup_iteration + setup->main_iteration; ++i) {
+        pthread_barrier_wait(&setup->barrier);
+        pthread_barrier_wait(&setup->barrier);
+        // each pass timed on its own, only main passes counted
+        utils::tsc_start<utils::TSC_MAIN>();
+        pkt->error |= benchmark_loads(setup->mem_region, setup->loop_count, 1);
+        const uint64_t ticks = utils::tsc_stop<utils::TSC_MAIN>();
+        if (i >= setup->warmup_iteration) {
+            main_ticks += ticks;
+        }
+        pthread_barrier_wait(&setup->barrier);
+    }
+    pkt->elapsed_time = main_ticks * utils::ns_per_tick() / 1e9;
+    return NULL;
+}
+
+// sizes from min_size to max_size, num_steps points per doubling; each size
+// is rounded down so that every page is whole and the chase count is a
+// multiple of the 256x unrolled loop
+std::vector<uint64_t> get_sweep_sizes(
+    uint64_t min_size, uint64_t max_size, uint64_t num_steps, uint64_t page, uint64_t stride)
+{
+    uint64_t unit = page;
+    while ((unit / stride) % 256 != 0) {
+        unit += page;
+    }
+    std::vector<uint64_t> sizes;
+    for (uint64_t base = std::max(min_size, unit); base < max_size; base *= 2) {
+        for (uint64_t step = 0; step < std::max<uint64_t>(num_steps, 1); ++step) {
+            const uint64_t sweep_size = (base + base * step / num_steps) / unit * unit;
+            if (sweep_size >= unit && sweep_size < max_size &&
+                (sizes.empty() || sweep_size > sizes.back())) {
+                sizes.push_back(sweep_size);
+            }
+        }
+    }
+    sizes.push_back(max_size);
+    return sizes;
+}
 
 int main(int argc, char **argv)
 {
     utils::start_timer("startup");
+    const utils::Options options(argc, argv);
     if (argc < 8) {
         print_usage();
         return 1;
     }
+    utils::PerfGroup perf(options.has("perf"));
+    perf.start();
+    utils::Reporter& reporter = utils::Reporter::get();
+    reporter.open("lat_mem_rd", options);
     // get command line arguments
-    const uint64_t size = 1024 * static_cast<uint64_t>(atoi(argv[1]));
-    const uint64_t page = 1024 * static_cast<uint64_t>(atoi(argv[2]));
-    const uint64_t stride = static_cast<uint64_t>(atoi(argv[3]));
+    const uint64_t size = 1024 * strtoull(argv[1], NULL, 10);
+    const uint64_t page = 1024 * strtoull(argv[2], NULL, 10);
+    const uint64_t stride = strtoull(argv[3], NULL, 10);
     const std::string pattern = argv[4];
-    const uint64_t warmup_iteration = atoi(argv[5]);
-    const uint64_t main_iteration = atoi(argv[6]);
-    const float core_freq_ghz = atof(argv[7]);
+    const uint64_t warmup_iteration = strtoull(argv[5], NULL, 10);
+    const uint64_t main_iteration = strtoull(argv[6], NULL, 10);
+    const float core_freq_ghz = utils::resolve_core_freq(atof(argv[7]), std::cout);
     bool use_hugepage = false;
     if (argc >= 9) {
         const std::string os_page = argv[8];
@@ -47,8 +278,9 @@ int main(int argc, char **argv)
     }
     utils::MemType region2_type = utils::MemType::NATIVE;
     uint64_t region2_size = 0;
+    std::string r2_type_str = "native";
     if (argc >= 11) {
-        const std::string r2_type_str = argv[9];
+        r2_type_str = argv[9];
         if (r2_type_str == "remote" || r2_type_str == "Remote") {
           region2_type = utils::MemType::REMOTE1;
         } else if (r2_type_str == "remote1" || r2_type_str == "Remote1") {
@@ -58,51 +290,334 @@ int main(int argc, char **argv)
         } else if (r2_type_str == "device" || r2_type_str == "Device") {
             region2_type = utils::MemType::DEVICE;
         }
-        region2_size = 1024 * static_cast<uint64_t>(atoi(argv[10]));
+        region2_size = 1024 * strtoull(argv[10], NULL, 10);
     }
     uint64_t active_size = size;
     if (argc >= 12) {
-        active_size = 1024 * static_cast<uint64_t>(atoi(argv[11]));
+        active_size = 1024 * strtoull(argv[11], NULL, 10);
     }
     bool migrate = false;
     if (argc >= 13) {
         std::string do_migrate = argv[12];
         migrate = (do_migrate == "migrate" || do_migrate == "Migrate");
     }
+    if (pattern != "stride" && pattern != "pageRand" && pattern != "allRand") {
+        print_usage();
+        return 1;
+    }
     std::string tag = "lat_mem_rd_" + pattern;
+    reporter.config("size_kb", size / 1024);
+    reporter.config("page_kb", page / 1024);
+    reporter.config("stride", stride);
+    reporter.config("pattern", pattern);
+    reporter.config("warmup_iters", warmup_iteration);
+    reporter.config("main_iters", main_iteration);
+    reporter.config("core_ghz", core_freq_ghz);
+    reporter.config("hugepage", use_hugepage);
+    reporter.config("region2_type", r2_type_str);
+    reporter.config("region2_kb", region2_size / 1024);
+    reporter.config("active_kb", active_size / 1024);
+    reporter.config("seed", options.getUint("seed", 0));
+    std::vector<uint64_t> mlp_list = options.getUintList("mlp");
+    for (const uint64_t& num_chains : mlp_list) {
+        if (num_chains < 1 || num_chains > MAX_NUM_CHAINS) {
+            print_usage();
+            return 1;
+        }
+    }
     // setup memory region
     utils::MemRegion::Handle mem_region(
         new utils::MemRegion(
             size, active_size, page, stride, use_hugepage, region2_type, region2_size));
-    if (pattern == "stride") {
-        mem_region->stride_init();
-    } else if (pattern == "pageRand") {
-        mem_region->page_random_init();
-    } else if (pattern == "allRand") {
-        mem_region->all_random_init();
-    } else {
-        print_usage();
-        return 1;
-    }
-    //mem_region->dump();
+    mem_region->setSeed(options.getUint("seed", 0));
+    auto init_pattern = [&mem_region, &pattern](uint32_t num_chains) -> void {
+        if (pattern == "stride") {
+            mem_region->stride_init(num_chains);
+        } else if (pattern == "pageRand") {
+            mem_region->page_random_init(num_chains);
+        } else {
+            mem_region->all_random_init(num_chains);
+        }
+    };
     // input check
     static const uint64_t loop_unroll = 256;
     const uint64_t num_chases = mem_region->numActiveLines();
     assert (num_chases % loop_unroll == 0);
     const uint64_t unrolled_loop_count = num_chases / loop_unroll;
+    bool error = false;
+    // memory-level parallelism: K chains advanced in lockstep
+    if (!mlp_list.empty()) {
+        std::cout << "Memory region setup done; MLP Pointer-Chasing begins ..." << std::endl;
+        utils::end_timer("startup", std::cout);
+        auto measure = [&](uint64_t num_chains) -> double {
+            init_pattern(num_chains);
+            // each chain is advanced by the same # of hops per iteration
+            const uint64_t chain_loop_count = std::max<uint64_t>(1, num_chases / num_chains / loop_unroll);
+            const uint64_t num_refs = chain_loop_count * loop_unroll * num_chains * main_iteration;
+            const std::string mlp_tag = tag + "_mlp" + std::to_string(num_chains);
+            error |= benchmark_mlp_loads(mem_region, chain_loop_count, warmup_iteration);
+            utils::tsc_start<utils::TSC_MAIN>();
+            error |= benchmark_mlp_loads(mem_region, chain_loop_count, main_iteration);
+            const double elapsed_time = utils::report_ticks(mlp_tag, std::cout, utils::tsc_stop<utils::TSC_MAIN>());
+            return 1e9 * elapsed_time / num_refs;
+        };
+        // unloaded latency from a single chain, whether or not K=1 is listed
+        const double base_ns = measure(1);
+        std::ostringstream table;
+        table << "base: 1 chain, per-ref(ns)=" << std::fixed << std::setprecision(3) << base_ns << std::endl;
+        table << std::setw(8) << "chains" << std::setw(16) << "per-ref(ns)" << std::setw(16) << "per-ref(cycle)"
+            << std::setw(16) << "per-chain(ns)" << std::setw(16) << "outstanding" << std::endl;
+        for (const uint64_t& num_chains : mlp_list) {
+            const double per_ref_ns = (num_chains == 1) ? base_ns : measure(num_chains);
+            // by Little's law, the unloaded latency over the per-ref time is
+            // the average # of misses kept in flight
+            table << std::fixed << std::setprecision(3) << std::setw(8) << num_chains
+                << std::setw(16) << per_ref_ns << std::setw(16) << per_ref_ns * core_freq_ghz
+                << std::setw(16) << per_ref_ns * num_chains << std::setw(16) << base_ns / per_ref_ns << std::endl;
+            reporter.add(utils::ResultRecord()
+                .config("mode", "mlp").config("chains", num_chains)
+                .metric("per_ref_ns", per_ref_ns).metric("per_ref_cycle", per_ref_ns * core_freq_ghz)
+                .metric("base_ns", base_ns)
+                .metric("per_chain_ns", per_ref_ns * num_chains).metric("outstanding", base_ns / per_ref_ns));
+        }
+        std::cout << std::endl << table.str() << std::endl;
+        return error;
+    }
+    // per-hop latency distribution
+    if (options.has("hist")) {
+        const uint64_t sample_every = std::max<uint64_t>(1, options.getUint("hist", 16));
+        init_pattern(1);
+        const uint64_t overhead = utils::rdtscp_overhead();
+        std::cout << "Memory region setup done; Sampled Pointer-Chasing begins ..." << std::endl;
+        std::cout << "Sampling 1 of every " << sample_every << " hops, rdtscp overhead(tick)=" << overhead << std::endl;
+        utils::end_timer("startup", std::cout);
+        utils::LogHistogram hist;
+        error |= benchmark_sampled_loads(mem_region, num_chases, warmup_iteration, sample_every, overhead, hist);
+        hist.clear();
+        error |= benchmark_sampled_loads(mem_region, num_chases, main_iteration, sample_every, overhead, hist);
+        const double ns_per_tick = utils::ns_per_tick();
+        utils::dump_clock_info(std::cout);
+        hist.dumpPercentiles(std::cout, ns_per_tick, "ns");
+        hist.dumpPercentiles(std::cout, ns_per_tick * core_freq_ghz, "cycle");
+        std::cout << std::endl;
+        hist.dumpBuckets(std::cout, ns_per_tick, "ns");
+        std::cout << std::endl;
+        reporter.add(utils::ResultRecord()
+            .config("mode", "hist").config("sample_every", sample_every)
+            .metric("samples", hist.getCount()).metric("mean_ns", hist.getMean() * ns_per_tick)
+            .metric("p50_ns", hist.getPercentile(50) * ns_per_tick)
+            .metric("p90_ns", hist.getPercentile(90) * ns_per_tick)
+            .metric("p99_ns", hist.getPercentile(99) * ns_per_tick)
+            .metric("p999_ns", hist.getPercentile(99.9) * ns_per_tick));
+        return error;
+    }
+    // cache-to-cache latency by the coherence state the producer leaves behind
+    if (options.has("c2c")) {
+        std::vector<std::string> states;
+        std::stringstream ss(options.get("c2c", "M,E,S"));
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (item != "M" && item != "E" && item != "S") {
+                print_usage();
+                return 1;
+            }
+            states.push_back(item);
+        }
+        // M dirties each element at byte offset 32, which must own its line
+        if (stride < 64) {
+            std::cerr << "stride=" << stride << " must be at least 64 for --c2c" << std::endl;
+            exit(1);
+        }
+        init_pattern(1);
+        C2cSetup setup;
+        setup.mem_region = mem_region;
+        setup.loop_count = unrolled_loop_count;
+        setup.warmup_iteration = warmup_iteration;
+        setup.main_iteration = main_iteration;
+        const std::vector<uint32_t> core_ids = {
+            static_cast<uint32_t>(options.getUint("producer", 0)),
+            static_cast<uint32_t>(options.getUint("consumer", 1)),
+            static_cast<uint32_t>(options.getUint("sharer", 2))};
+        utils::ThreadHelper<C2cThreadPacket> threads(core_ids);
+        for (uint32_t i = 0; i < core_ids.size(); ++i) {
+            threads.getPacket(i).setup = &setup;
+        }
+        std::cout << "Memory region setup done; Cache-to-Cache Pointer-Chasing begins ..." << std::endl;
+        utils::end_timer("startup", std::cout);
+        std::ostringstream table;
+        table << std::setw(8) << "state" << std::setw(16) << "per-ref(ns)" << std::setw(16) << "per-ref(cycle)" << std::endl;
+        for (const std::string& state : states) {
+            setup.state = (state == "M") ? LineState::M : (state == "E") ? LineState::E : LineState::S;
+            pthread_barrier_init(&setup.barrier, NULL, core_ids.size());
+            threads.setRoutine(thread_c2c_producer, [](const uint32_t& idx) { return idx == 0; });
+            threads.setRoutine(thread_c2c_consumer, [](const uint32_t& idx) { return idx == 1; });
+            threads.setRoutine(thread_c2c_sharer, [](const uint32_t& idx) { return idx == 2; });
+            threads.create();
+            threads.join();
+            pthread_barrier_destroy(&setup.barrier);
+            for (uint32_t i = 0; i < core_ids.size(); ++i) {
+                error |= threads.getPacket(i).error;
+            }
+            const double per_ref_ns = 1e9 * threads.getPacket(1).elapsed_time / (num_chases * main_iteration);
+            table << std::fixed << std::setprecision(3) << std::setw(8) << state
+                << std::setw(16) << per_ref_ns << std::setw(16) << per_ref_ns * core_freq_ghz << std::endl;
+            reporter.add(utils::ResultRecord()
+                .config("mode", "c2c").config("state", state).config("cores", utils::join_list(core_ids))
+                .metric("per_ref_ns", per_ref_ns).metric("per_ref_cycle", per_ref_ns * core_freq_ghz));
+        }
+        std::cout << std::endl << table.str() << std::endl;
+        return error;
+    }
+    // loaded latency: chase on thread 0 under background bandwidth load
+    if (options.has("loaded")) {
+        const uint32_t num_loads = options.getUint("loaded", 1);
+        const std::string load_action = options.get("load_kernel", "prd");
+        std::vector<uint64_t> load_delays = options.getUintList("load_delay");
+        if (load_delays.empty()) {
+            load_delays.push_back(0);
+        }
+        uint64_t load_size = 1024 * options.getUint("load_size", size / 1024);
+        load_size = std::max<uint64_t>(load_size / 1024 / 1024 * 1024 * 1024, 1024 * 1024);
+        LoadedLatencySetup setup;
+        setup.mem_region = mem_region;
+        setup.loop_count = unrolled_loop_count;
+        setup.warmup_iteration = warmup_iteration;
+        setup.main_iteration = main_iteration;
+        setup.load_kernel = get_bw_kernel(load_action);
+        if (!setup.load_kernel) {
+            print_usage();
+            return 1;
+        }
+        init_pattern(1);
+        // thread 0 chases, the others generate load
+        const uint32_t num_threads = num_loads + 1;
+        const std::vector<uint32_t> core_ids = utils::CpuTopology::get().getPlacement(
+            options.get("placement"), num_threads, options.getUint("thread_step", 1), options.getUint("core_start", 0));
+        utils::ThreadHelper<LoadedThreadPacket> threads(core_ids);
+        const uint64_t load_region_size = (load_action == "pcp") ? 2 * load_size : load_size;
+        for (uint32_t i = 0; i < num_threads; ++i) {
+            LoadedThreadPacket& pkt = threads.getPacket(i);
+            pkt.setup = &setup;
+            if (i > 0) {
+                pkt.load_region.reset(new utils::MemRegion(
+                    load_region_size, load_region_size, page, stride, use_hugepage));
+                pkt.load_size = load_size;
+                pkt.load_loop_count = load_size / (16 * 64);
+            }
+        }
+        std::cout << "Memory region setup done; Loaded Pointer-Chasing begins ..." << std::endl;
+        utils::end_timer("startup", std::cout);
+        std::ostringstream table;
+        table << std::setw(12) << "delay" << std::setw(16) << "bw(MBpS)" << std::setw(16) << "per-ref(ns)"
+            << std::setw(16) << "per-ref(cycle)" << std::endl;
+        for (const uint64_t& load_delay : load_delays) {
+            setup.load_delay = load_delay;
+            setup.num_loads_started.store(0);
+            setup.stop.store(false);
+            threads.setRoutine(thread_chase, [](const uint32_t& idx) { return idx == 0; });
+            threads.setRoutine(thread_load, [](const uint32_t& idx) { return idx > 0; });
+            threads.create();
+            threads.join();
+            double bw_bps = 0;
+            for (uint32_t i = 1; i < num_threads; ++i) {
+                const LoadedThreadPacket& pkt = threads.getPacket(i);
+                if (pkt.elapsed_time > 0) {
+                    bw_bps += pkt.bytes / pkt.elapsed_time;
+                }
+            }
+            const LoadedThreadPacket& chase_pkt = threads.getPacket(0);
+            error |= chase_pkt.error;
+            const double per_ref_ns = 1e9 * chase_pkt.elapsed_time / (num_chases * main_iteration);
+            table << std::fixed << std::setprecision(3) << std::setw(12) << load_delay
+                << std::setw(16) << bw_bps / 1024 / 1024 << std::setw(16) << per_ref_ns
+                << std::setw(16) << per_ref_ns * core_freq_ghz << std::endl;
+            reporter.add(utils::ResultRecord()
+                .config("mode", "loaded").config("load_kernel", load_action).config("load_threads", num_loads)
+                .config("load_kb", load_size / 1024).config("load_delay", load_delay)
+                .config("cores", utils::join_list(core_ids))
+                .metric("load_bw_mbps", bw_bps / 1024 / 1024)
+                .metric("per_ref_ns", per_ref_ns).metric("per_ref_cycle", per_ref_ns * core_freq_ghz));
+        }
+        std::cout << std::endl << table.str() << std::endl;
+        return error;
+    }
+    // working-set sweep: reuse the allocation, rebuild the chain over growing prefixes
+    if (options.has("sweep")) {
+        const std::vector<uint64_t> sweep_sizes = get_sweep_sizes(
+            1024 * options.getUint("sweep", 4), active_size, options.getUint("sweep_steps", 1), page, stride);
+        std::cout << "Memory region setup done; Sweep Pointer-Chasing begins ..." << std::endl;
+        utils::end_timer("startup", std::cout);
+        std::ostringstream table;
+        table << std::setw(16) << "size(KB)" << std::setw(16) << "per-ref(ns)" << std::setw(16) << "per-ref(cycle)" << std::endl;
+        for (const uint64_t& sweep_size : sweep_sizes) {
+            mem_region->setActiveSize(sweep_size);
+            init_pattern(1);
+            const uint64_t sweep_chases = mem_region->numActiveLines();
+            const uint64_t sweep_loop_count = sweep_chases / loop_unroll;
+            // keep the # of chases per point constant across sizes
+            const uint64_t scale = active_size / sweep_size;
+            const std::string sweep_tag = tag + "_" + std::to_string(sweep_size / 1024) + "KB";
+            error |= benchmark_loads(mem_region, sweep_loop_count, warmup_iteration * scale);
+            utils::tsc_start<utils::TSC_MAIN>();
+            error |= benchmark_loads(mem_region, sweep_loop_count, main_iteration * scale);
+            const double elapsed_time = utils::report_ticks(sweep_tag, std::cout, utils::tsc_stop<utils::TSC_MAIN>());
+            const double per_ref_ns = 1e9 * elapsed_time / (sweep_chases * main_iteration * scale);
+            table << std::fixed << std::setprecision(3) << std::setw(16) << sweep_size / 1024
+                << std::setw(16) << per_ref_ns << std::setw(16) << per_ref_ns * core_freq_ghz << std::endl;
+            reporter.add(utils::ResultRecord()
+                .config("mode", "sweep").config("sweep_kb", sweep_size / 1024)
+                .metric("per_ref_ns", per_ref_ns).metric("per_ref_cycle", per_ref_ns * core_freq_ghz));
+        }
+        std::cout << std::endl << table.str() << std::endl;
+        return error;
+    }
     // run
+    init_pattern(1);
+    //mem_region->dump();
     std::cout << "Memory region setup done; Pointer-Chasing begins ..." << std::endl;
     std::cout << "Total iterations: " << main_iteration << ", # of pointer chases per iter: " << num_chases << std::endl;
+    perf.dump(std::cout, "startup", perf.stop());
     utils::end_timer("startup", std::cout);
-    bool error = false;
     utils::start_timer("warmup");
+    perf.start();
     // warm-up some iterations
     error |= benchmark_loads(mem_region, unrolled_loop_count, warmup_iteration);
+    const std::vector<double> warmup_counts = perf.stop();
     utils::end_timer("warmup", std::cout);
+    perf.dump(std::cout, "warmup", warmup_counts, num_chases * warmup_iteration);
     // timer
-    utils::start_timer(tag);
-    error |= benchmark_loads(mem_region, unrolled_loop_count, main_iteration);
-    utils::end_timer(tag, std::cout, num_chases * main_iteration, core_freq_ghz);
+    const utils::RepeatConfig repeat(options);
+    if (repeat.isRepeated()) {
+        // main phase repeated, one per-ref sample each
+        const uint64_t num_refs = num_chases * main_iteration;
+        utils::Repeater repeater(repeat);
+        perf.start();
+        const utils::SampleStats stats = repeater.run(
+            [&]() { error |= benchmark_loads(mem_region, unrolled_loop_count, main_iteration); },
+            [&num_refs](double elapsed_time) { return 1e9 * elapsed_time / num_refs; });
+        const std::vector<double> main_counts = perf.stop();
+        utils::dump_stats(std::cout, tag, "per-ref(ns)", stats);
+        utils::dump_stats(std::cout, tag, "per-ref(cycle)", stats, core_freq_ghz);
+        reporter.add(utils::ResultRecord()
+            .config("mode", "chase")
+            .metric("per_ref_ns", stats.mean).metric("per_ref_cycle", stats.mean * core_freq_ghz)
+            .stats("per_ref_ns", stats));
+        perf.dump(std::cout, tag, main_counts, num_refs * repeater.getSamples().size());
+    } else {
+        perf.start();
+        utils::tsc_start<utils::TSC_MAIN>();
+        error |= benchmark_loads(mem_region, unrolled_loop_count, main_iteration);
+        const uint64_t main_ticks = utils::tsc_stop<utils::TSC_MAIN>();
+        const std::vector<double> main_counts = perf.stop();
+        utils::report_ticks(tag, std::cout, main_ticks, num_chases * main_iteration, core_freq_ghz);
+        const double elapsed_time = main_ticks * utils::ns_per_tick() / 1e9;
+        const double per_ref_ns = 1e9 * elapsed_time / (num_chases * main_iteration);
+        reporter.add(utils::ResultRecord()
+            .config("mode", "chase")
+            .metric("elapsed_s", elapsed_time)
+            .metric("per_ref_ns", per_ref_ns).metric("per_ref_cycle", per_ref_ns * core_freq_ghz));
+        perf.dump(std::cout, tag, main_counts, num_chases * main_iteration);
+    }
     // page migration
     if (migrate) {
         utils::start_timer("migration");
@@ -111,9 +626,16 @@ int main(int argc, char **argv)
         // warm-up
         error |= benchmark_loads(mem_region, unrolled_loop_count, warmup_iteration);
         // benchmark
-        utils::start_timer(tag);
+        utils::tsc_start<utils::TSC_MAIN>();
         error |= benchmark_loads(mem_region, unrolled_loop_count, main_iteration);
-        utils::end_timer(tag, std::cout, num_chases * main_iteration, core_freq_ghz);
+        const uint64_t main_ticks = utils::tsc_stop<utils::TSC_MAIN>();
+        utils::report_ticks(tag, std::cout, main_ticks, num_chases * main_iteration, core_freq_ghz);
+        const double elapsed_time = main_ticks * utils::ns_per_tick() / 1e9;
+        const double per_ref_ns = 1e9 * elapsed_time / (num_chases * main_iteration);
+        reporter.add(utils::ResultRecord()
+            .config("mode", "migrated")
+            .metric("elapsed_s", elapsed_time)
+            .metric("per_ref_ns", per_ref_ns).metric("per_ref_cycle", per_ref_ns * core_freq_ghz));
     }
     return error;
 }
@@ -138,3 +660,90 @@ bool benchmark_loads(const utils::MemRegion::Handle &mem_region, uint64_t loop_c
     }
     return (p1 == NULL);
 }
+
+// advance K chains by one hop each; unrolled at compile time
+template <uint32_t K>
+struct ChaseStep {
+    static inline void run(char** p[]) {
+        ChaseStep<K - 1>::run(p);
+        p[K - 1] = (char **)*p[K - 1];
+    }
+};
+
+template <>
+struct ChaseStep<0> {
+    static inline void run(char** p[]) { }
+};
+
+#undef LOOP1
+#define LOOP1     ChaseStep<K>::run(p);
+
+template <uint32_t K>
+bool benchmark_mlp_loads_k(const utils::MemRegion::Handle &mem_region, uint64_t loop_count, uint64_t num_iter)
+{
+    char **p[K];
+    uint64_t i = 0;
+    while (num_iter > 0) {
+        for (uint32_t k = 0; k < K; ++k) {
+            p[k] = mem_region->getChainStartPoint(k);
+        }
+        -- num_iter;
+        for (i = 0; i < loop_count; ++i) {
+            LOOP256;
+        }
+    }
+    bool error = false;
+    for (uint32_t k = 0; k < K; ++k) {
+        error |= (p[k] == NULL);
+    }
+    return error;
+}
+
+// table of the template instances, indexed by K-1
+template <uint32_t K>
+struct MlpTable {
+    static void fill(std::vector<bool (*)(const utils::MemRegion::Handle&, uint64_t, uint64_t)>& table) {
+        MlpTable<K - 1>::fill(table);
+        table.push_back(benchmark_mlp_loads_k<K>);
+    }
+};
+
+template <>
+struct MlpTable<0> {
+    static void fill(std::vector<bool (*)(const utils::MemRegion::Handle&, uint64_t, uint64_t)>& table) { }
+};
+
+bool benchmark_mlp_loads(const utils::MemRegion::Handle &mem_region, uint64_t loop_count, uint64_t num_iter)
+{
+    static std::vector<bool (*)(const utils::MemRegion::Handle&, uint64_t, uint64_t)> table;
+    if (table.empty()) {
+        MlpTable<MAX_NUM_CHAINS>::fill(table);
+    }
+    return table.at(mem_region->numChains() - 1)(mem_region, loop_count, num_iter);
+}
+
+// instrumented chase: one out of every sample_every hops is bracketed by
+// rdtscp; the untimed hops in between keep the sampling overhead low
+bool benchmark_sampled_loads(
+    const utils::MemRegion::Handle &mem_region, uint64_t num_chases, uint64_t num_iter,
+    uint64_t sample_every, uint64_t overhead, utils::LogHistogram& hist)
+{
+    char **start = mem_region->getStartPoint();
+    char **p1 = start;
+    uint64_t i = 0;
+    uint64_t k = 0;
+    while (num_iter > 0) {
+        p1 = start;
+        -- num_iter;
+        for (i = 0; i < num_chases; i += sample_every) {
+            for (k = 1; k < sample_every; ++k) {
+                p1 = (char **)*p1;
+            }
+            const uint64_t t1 = utils::rdtscp();
+            p1 = (char **)*p1;
+            const uint64_t t2 = utils::rdtscp();
+            hist.add((t2 - t1 > overhead) ? (t2 - t1 - overhead) : 0);
+        }
+    }
+    return (p1 == NULL);
+}
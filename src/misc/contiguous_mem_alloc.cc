@@ -215,7 +215,7 @@ int main() {
     const uint64_t num_chases = region_size / line_size;
     std::cout << "# of pointer chases per iter: " << num_chases << std::endl;
     const uint64_t loop_count = num_chases / loop_unroll;
-    const float core_freq_ghz = 1.4;
+    const float core_freq_ghz = utils::resolve_core_freq(0, std::cout);
     assert (num_chases % loop_unroll == 0);
     bool error = false;
     error |= benchmark_loads(region_addr, loop_count, num_iters/10);
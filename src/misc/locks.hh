@@ -0,0 +1,200 @@
+#ifndef __LOCKS_HH__
+#define __LOCKS_HH__
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <pthread.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "utils/lib_threading.hh"
+
+// common interface: every lock has a per-thread Node, passed to lock/unlock;
+// it is empty for locks that don't queue
+
+// lines handed out to queue nodes, one per node
+template <class T>
+T* alloc_lines(uint32_t num) {
+    void* ptr = NULL;
+    if (posix_memalign(&ptr, 64, num * sizeof(T)) != 0) {
+        std::cerr << "failed to allocate lock nodes" << std::endl;
+        exit(1);
+    }
+    T* lines = static_cast<T*>(ptr);
+    for (uint32_t i = 0; i < num; ++i) {
+        new (&lines[i]) T();
+    }
+    return lines;
+}
+
+class PthreadLock {
+  public:
+    struct Node { };
+
+    PthreadLock() { pthread_mutex_init(&mutex_, NULL); }
+    ~PthreadLock() { pthread_mutex_destroy(&mutex_); }
+
+    void lock(Node& node) { pthread_mutex_lock(&mutex_); }
+    void unlock(Node& node) { pthread_mutex_unlock(&mutex_); }
+
+  private:
+    pthread_mutex_t mutex_;
+};
+
+// test-and-test-and-set: spin on a plain load, only try the xchg when free
+class TtasLock {
+  public:
+    struct Node { };
+
+    void lock(Node& node) {
+        while (true) {
+            while (locked_.load(std::memory_order_relaxed)) {
+                utils::cpu_relax();
+            }
+            if (!locked_.exchange(true, std::memory_order_acquire)) {
+                return;
+            }
+        }
+    }
+    void unlock(Node& node) { locked_.store(false, std::memory_order_release); }
+
+  private:
+    alignas(64) std::atomic<bool> locked_ {false};
+};
+
+// FIFO: take a ticket, wait until it is served
+class TicketLock {
+  public:
+    struct Node { };
+
+    void lock(Node& node) {
+        const uint32_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+        while (serving_.load(std::memory_order_acquire) != ticket) {
+            utils::cpu_relax();
+        }
+    }
+    void unlock(Node& node) {
+        serving_.store(serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+  private:
+    alignas(64) std::atomic<uint32_t> next_ {0};
+    alignas(64) std::atomic<uint32_t> serving_ {0};
+};
+
+// queue of per-thread nodes; each waiter spins on its own node
+class McsLock {
+  public:
+    struct alignas(64) Node {
+        std::atomic<Node*> next {nullptr};
+        std::atomic<bool> locked {false};
+    };
+
+    void lock(Node& node) {
+        node.next.store(nullptr, std::memory_order_relaxed);
+        node.locked.store(true, std::memory_order_relaxed);
+        Node* pred = tail_.exchange(&node, std::memory_order_acq_rel);
+        if (pred != nullptr) {
+            pred->next.store(&node, std::memory_order_release);
+            while (node.locked.load(std::memory_order_acquire)) {
+                utils::cpu_relax();
+            }
+        }
+    }
+    void unlock(Node& node) {
+        Node* next = node.next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            Node* expected = &node;
+            if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+                return;
+            }
+            // a successor is linking itself in
+            while ((next = node.next.load(std::memory_order_acquire)) == nullptr) {
+                utils::cpu_relax();
+            }
+        }
+        next->locked.store(false, std::memory_order_release);
+    }
+
+  private:
+    alignas(64) std::atomic<Node*> tail_ {nullptr};
+};
+
+// implicit queue: each waiter spins on its predecessor's node, and takes
+// that node over on unlock; nodes move between threads, so they live in
+// the lock and a thread's Node must persist across lock uses
+class ClhLock {
+  public:
+    struct alignas(64) QNode {
+        std::atomic<bool> locked {false};
+    };
+    struct Node {
+        QNode* mine = nullptr;
+        QNode* pred = nullptr;
+    };
+
+    explicit ClhLock(uint32_t max_threads) :
+        qnodes_ (alloc_lines<QNode>(max_threads + 1))
+    {
+        tail_.store(&qnodes_[0]);
+    }
+    ~ClhLock() { free(qnodes_); }
+
+    void initNode(Node& node, uint32_t tid) { node.mine = &qnodes_[tid + 1]; }
+
+    void lock(Node& node) {
+        node.mine->locked.store(true, std::memory_order_relaxed);
+        node.pred = tail_.exchange(node.mine, std::memory_order_acq_rel);
+        while (node.pred->locked.load(std::memory_order_acquire)) {
+            utils::cpu_relax();
+        }
+    }
+    void unlock(Node& node) {
+        QNode* pred = node.pred;
+        node.mine->locked.store(false, std::memory_order_release);
+        node.mine = pred;
+    }
+
+  private:
+    QNode* qnodes_;
+    alignas(64) std::atomic<QNode*> tail_ {nullptr};
+};
+
+// raw futex mutex: 0 free, 1 locked, 2 locked with waiters
+class FutexLock {
+  public:
+    struct Node { };
+
+    void lock(Node& node) {
+        int c = 0;
+        if (state_.compare_exchange_strong(c, 1, std::memory_order_acquire)) {
+            return;
+        }
+        if (c != 2) {
+            c = state_.exchange(2, std::memory_order_acquire);
+        }
+        while (c != 0) {
+            futex_(FUTEX_WAIT_PRIVATE, 2);
+            c = state_.exchange(2, std::memory_order_acquire);
+        }
+    }
+    void unlock(Node& node) {
+        if (state_.fetch_sub(1, std::memory_order_release) != 1) {
+            state_.store(0, std::memory_order_release);
+            futex_(FUTEX_WAKE_PRIVATE, 1);
+        }
+    }
+
+  private:
+    void futex_(int op, int val) {
+        syscall(SYS_futex, reinterpret_cast<int*>(&state_), op, val, NULL, NULL, 0);
+    }
+
+    alignas(64) std::atomic<int> state_ {0};
+};
+
+#endif
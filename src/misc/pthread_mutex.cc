@@ -1,113 +1,281 @@
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <pthread.h>
-#include <sched.h>
-#include <sys/sysinfo.h>
 
 #include "utils/lib_mem_region.hh"
+#include "utils/lib_options.hh"
+#include "utils/lib_threading.hh"
 #include "utils/lib_timing.hh"
+#include "misc/locks.hh"
+
+enum class LockType { PTHREAD, TTAS, TICKET, MCS, CLH, FUTEX };
+
+// state only touched while holding the lock; it travels with the lock
+struct alignas(64) GuardedState {
+    uint64_t count;
+    uint64_t last_release;
+    uint32_t last_owner;
+};
+
+// one phase of the pool: a lock type, a critical section, a thread count
+struct LockSetup {
+    PthreadLock pthread_lock;
+    TtasLock ttas_lock;
+    TicketLock ticket_lock;
+    McsLock mcs_lock;
+    ClhLock* clh_lock = nullptr;
+    FutexLock futex_lock;
+    GuardedState state;
+    // shared lines touched in the critical section, 64B apart
+    volatile uint64_t* lines = nullptr;
+    LockType lock_type = LockType::PTHREAD;
+    uint32_t num_threads = 0;
+    uint32_t cs_lines = 0;
+    uint64_t outside_spins = 0;
+    std::chrono::steady_clock::time_point deadline;
+    alignas(64) std::atomic<bool> stop {false};
+};
 
-class ThreadPacket {
+class ThreadPacket : public utils::BaseThreadPacket {
   public:
-    ThreadPacket(uint32_t tid) :
-        thread_id (tid)
-    { }
+    ThreadPacket() = default;
     ~ThreadPacket() = default;
 
-    uint32_t thread_id;
+    LockSetup* setup = nullptr;
+    ClhLock::Node clh_node;
+    // results of the last phase
+    uint64_t num_acquires = 0;
+    uint64_t handoff_ticks = 0;
+    uint64_t num_handoffs = 0;
+    double elapsed_s = 0;
 };
 
-// global defined locks
-pthread_mutex_t g_flow_mutex;
-pthread_cond_t  g_flow_cond;
-uint32_t g_flow_step;
-
-// thread function
-void *thread_work(void *ptr) {
-    const ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
-    std::string thread_sign = "thread " + std::to_string(pkt->thread_id);
-    // two timers
-    std::string timer_full = thread_sign + " full";
-    std::string timer_work = thread_sign + " work";
-    // start full timer
-    utils::start_timer(timer_full);
-    // cond_wait w/ cond variable
-    pthread_mutex_lock(&g_flow_mutex);
-    while (g_flow_step != pkt->thread_id) {
-        pthread_cond_wait(&g_flow_cond, &g_flow_mutex);
+static inline void spin(uint64_t num_spins) {
+    for (uint64_t k = 0; k < num_spins; ++k) {
+        __asm__ __volatile__("nop");
     }
-    // start work timer
-    utils::start_timer(timer_work);
-    // real work
-    const uint64_t loop_count = 20000000 * 20;
-    double sum = 1;
-    for (uint64_t i = 1; i <= loop_count; ++i) {
-        if (i % 2 == 0) {
-            sum *= static_cast<double>(i);
-        } else {
-            sum /= static_cast<double>(i);
+}
+
+template <class Lock>
+void lock_loop(ThreadPacket* pkt, Lock& lock, typename Lock::Node& node)
+{
+    LockSetup* setup = pkt->setup;
+    const uint32_t tid = pkt->getThreadId();
+    const bool timekeeper = (tid == 0);
+    uint64_t num_acquires = 0;
+    uint64_t handoff_ticks = 0;
+    uint64_t num_handoffs = 0;
+    const auto time_begin = std::chrono::steady_clock::now();
+    while (!setup->stop.load(std::memory_order_relaxed)) {
+        const uint64_t wait_tick = utils::rdtscp();
+        lock.lock(node);
+        const uint64_t acquire_tick = utils::rdtscp();
+        // handoff: previous holder's release, or our arrival if later
+        if (setup->state.last_owner != tid && setup->state.last_release > 0) {
+            handoff_ticks += acquire_tick - std::max(wait_tick, setup->state.last_release);
+            ++ num_handoffs;
+        }
+        ++ setup->state.count;
+        for (uint32_t l = 0; l < setup->cs_lines; ++l) {
+            setup->lines[l * 8] += 1;
+        }
+        setup->state.last_owner = tid;
+        setup->state.last_release = utils::rdtscp();
+        lock.unlock(node);
+        ++ num_acquires;
+        spin(setup->outside_spins);
+        if (timekeeper && (num_acquires & 63) == 0 &&
+            std::chrono::steady_clock::now() > setup->deadline) {
+            setup->stop.store(true, std::memory_order_relaxed);
         }
     }
-    // end timer
-    if (sum > 0) {
-        utils::end_timer(timer_work, std::cout);
-        utils::end_timer(timer_full, std::cout);
+    const auto time_end = std::chrono::steady_clock::now();
+    pkt->num_acquires = num_acquires;
+    pkt->handoff_ticks = handoff_ticks;
+    pkt->num_handoffs = num_handoffs;
+    pkt->elapsed_s = std::chrono::duration_cast<std::chrono::duration<double>>(time_end - time_begin).count();
+}
+
+// threads beyond this config's count exit at once, so they hold no cpu
+void *thread_lock(void *ptr)
+{
+    ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
+    LockSetup* setup = pkt->setup;
+    pkt->num_acquires = 0;
+    pkt->num_handoffs = 0;
+    if (pkt->getThreadId() >= setup->num_threads) {
+        return NULL;
+    }
+    switch (setup->lock_type) {
+    case LockType::PTHREAD: {
+        PthreadLock::Node node;
+        lock_loop(pkt, setup->pthread_lock, node);
+        break;
+    }
+    case LockType::TTAS: {
+        TtasLock::Node node;
+        lock_loop(pkt, setup->ttas_lock, node);
+        break;
+    }
+    case LockType::TICKET: {
+        TicketLock::Node node;
+        lock_loop(pkt, setup->ticket_lock, node);
+        break;
+    }
+    case LockType::MCS: {
+        McsLock::Node node;
+        lock_loop(pkt, setup->mcs_lock, node);
+        break;
+    }
+    case LockType::CLH:
+        lock_loop(pkt, *setup->clh_lock, pkt->clh_node);
+        break;
+    case LockType::FUTEX: {
+        FutexLock::Node node;
+        lock_loop(pkt, setup->futex_lock, node);
+        break;
+    }
     }
-    // cond_broadcast w/ cond variable
-    ++ g_flow_step;
-    pthread_cond_broadcast(&g_flow_cond);
-    pthread_mutex_unlock(&g_flow_mutex);
     return NULL;
 }
 
+LockType get_lock_type(const std::string& name) {
+    if (name == "pthread") return LockType::PTHREAD;
+    if (name == "ttas") return LockType::TTAS;
+    if (name == "ticket") return LockType::TICKET;
+    if (name == "mcs") return LockType::MCS;
+    if (name == "clh") return LockType::CLH;
+    if (name == "futex") return LockType::FUTEX;
+    std::cerr << "unknown lock: " << name << std::endl;
+    exit(1);
+}
+
 int main(int argc, char **argv)
 {
-    uint32_t thread_step = 1;
-    if (argc > 1) {
-        thread_step = atoi(argv[1]);
-    }
-    // init locks
-    pthread_mutex_init(&g_flow_mutex, NULL);
-    pthread_cond_init(&g_flow_cond, NULL);
-    g_flow_step = 0;
-    // prepare thread attrs, packets
-    const uint32_t num_threads = get_nprocs();
-    if (num_threads % thread_step > 0) {
-        std::cout << "expect num_threads=" << num_threads << " is a multiple of thread_step=" << thread_step << std::endl;
+    utils::start_timer("startup");
+    const utils::Options options(argc, argv);
+    // input parameters
+    if (argc < 4) {
+        std::cout << "Usage: ./pthread_mutex <duration_ms> <max threads> <thread mapping step> <core-id start>" << std::endl;
+        std::cout << "\tlock shoot-out, for 1,2,4,..,max threads" << std::endl;
+        std::cout << "\tthread mapping step: e.g. 2 leads to 0,1,2,3 -> 0,2,1,3" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "\t--lock=<list>: pthread, ttas, ticket, mcs, clh, futex; default all" << std::endl;
+        std::cout << "\t--cs_lines=<list>: # of shared lines written in the critical section; default 0,1,4" << std::endl;
+        std::cout << "\t--outside=<N>: nop spins between two acquisitions; default 0" << std::endl;
+        std::cout << "\t--placement=compact|scatter|core|l3|<cpu list>: placement from the cpu topology, overrides the mapping step" << std::endl;
+        std::cout << "Example: ./pthread_mutex 200 16 1 0 --lock=ttas,mcs --cs_lines=0,4,16" << std::endl;
         exit(1);
     }
-    const uint32_t group_size = num_threads / thread_step;
-    std::vector<pthread_attr_t> attrs(num_threads);
-    std::vector<ThreadPacket> packets(num_threads, 0);
-    for (uint32_t i = 0; i < num_threads; ++i) {
-        // get thread - core mapping
-        const uint32_t group_id = i / group_size;
-        const uint32_t group_offset = i % group_size;
-        const uint32_t core_id = group_id + group_offset * thread_step;
-        //std::cout << "thread " << i << " -> core " << core_id << std::endl;
-        // set thread attribute
-        pthread_attr_init(&attrs[i]);
-        cpu_set_t cpuset;
-        CPU_ZERO(&cpuset);
-        CPU_SET(core_id, &cpuset);
-        pthread_attr_setaffinity_np(&attrs[i], sizeof(cpu_set_t), &cpuset);
-        // set packet passed to thread
-        packets[i] = i;
+    const uint64_t duration_ms = strtoull(argv[1], NULL, 10);
+    const uint32_t num_cores = utils::CpuTopology::get().numCpus();
+    const uint32_t max_threads_user = atoi(argv[2]);
+    const uint32_t max_threads = (max_threads_user > 0) ? max_threads_user : num_cores;
+    const uint32_t thread_step = atoi(argv[3]);
+    uint32_t core_id_start = 0;
+    if (argc >= 5) core_id_start = atoi(argv[4]);
+    std::vector<std::string> locks;
+    std::stringstream ss(options.get("lock", "pthread,ttas,ticket,mcs,clh,futex"));
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        get_lock_type(item);
+        locks.push_back(item);
     }
-    // create threads
-    std::vector<pthread_t> threads(num_threads);
-    for (uint32_t i = 0; i < threads.size(); ++i) {
-        pthread_create(&threads[i], &attrs[i], thread_work, (void*)(&packets[i]));
+    std::vector<uint64_t> cs_lines_list = options.getUintList("cs_lines");
+    if (cs_lines_list.empty()) {
+        cs_lines_list = {0, 1, 4};
     }
-    // wait threads
-    for (uint32_t i = 0; i < threads.size(); ++i) {
-        pthread_join(threads[i], NULL);
+    const uint64_t max_cs_lines = *std::max_element(cs_lines_list.begin(), cs_lines_list.end());
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t n = 1; n < max_threads; n *= 2) {
+        thread_counts.push_back(n);
     }
-    // destroy locks
-    pthread_mutex_destroy(&g_flow_mutex);
-    pthread_cond_destroy(&g_flow_cond);
-
-    return 0;
+    thread_counts.push_back(max_threads);
+    // shared lines of the critical section
+    const uint64_t region_size = std::max<uint64_t>(4096, (max_cs_lines * 64 + 4095) / 4096 * 4096);
+    utils::MemRegion line_region(region_size, region_size, 4096, 64);
+    LockSetup setup;
+    ClhLock clh_lock(max_threads);
+    setup.clh_lock = &clh_lock;
+    setup.lines = reinterpret_cast<volatile uint64_t*>(line_region.getStartPoint());
+    setup.outside_spins = options.getUint("outside", 0);
+    // calibrate before any thread spins
+    utils::dump_clock_info(std::cout);
+    // one set of max threads, created anew per config: threads beyond its count
+    // exit at once and the main thread blocks in join, so neither takes a cpu
+    // from the measured threads; the packets persist across configs
+    utils::ThreadHelper<ThreadPacket> threads(utils::CpuTopology::get().getPlacement(
+        options.get("placement"), max_threads, thread_step, core_id_start));
+    for (uint32_t i = 0; i < max_threads; ++i) {
+        threads.getPacket(i).setup = &setup;
+        clh_lock.initNode(threads.getPacket(i).clh_node, i);
+    }
+    threads.setRoutine(thread_lock, [](const uint32_t& idx) { return true; });
+    utils::end_timer("startup", std::cout);
+    // run
+    utils::start_timer("all");
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << std::setw(8) << "lock" << std::setw(8) << "threads" << std::setw(8) << "lines"
+        << std::setw(14) << "Macq/s" << std::setw(14) << "handoff(ns)"
+        << std::setw(10) << "jain" << std::setw(10) << "min/max" << std::endl;
+    uint32_t status = 0;
+    for (const std::string& lock : locks) {
+        for (const uint64_t& cs_lines : cs_lines_list) {
+            for (const uint32_t& num_threads : thread_counts) {
+                setup.lock_type = get_lock_type(lock);
+                setup.num_threads = num_threads;
+                setup.cs_lines = cs_lines;
+                setup.state.count = 0;
+                setup.state.last_release = 0;
+                setup.state.last_owner = 0;
+                setup.stop.store(false);
+                setup.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(duration_ms);
+                threads.create();
+                threads.join();
+                const double ns_per_tick = utils::ns_per_tick();
+                // throughput, handoff latency, fairness
+                uint64_t total_acquires = 0;
+                uint64_t handoff_ticks = 0;
+                uint64_t num_handoffs = 0;
+                uint64_t min_acquires = UINT64_MAX;
+                uint64_t max_acquires = 0;
+                double sum_squares = 0;
+                double max_elapsed_s = 0;
+                for (uint32_t i = 0; i < num_threads; ++i) {
+                    const ThreadPacket& pkt = threads.getPacket(i);
+                    total_acquires += pkt.num_acquires;
+                    handoff_ticks += pkt.handoff_ticks;
+                    num_handoffs += pkt.num_handoffs;
+                    min_acquires = std::min(min_acquires, pkt.num_acquires);
+                    max_acquires = std::max(max_acquires, pkt.num_acquires);
+                    sum_squares += static_cast<double>(pkt.num_acquires) * pkt.num_acquires;
+                    max_elapsed_s = std::max(max_elapsed_s, pkt.elapsed_s);
+                }
+                // the guarded counter catches a broken lock
+                if (setup.state.count != total_acquires) {
+                    std::cerr << lock << ": lost updates, " << setup.state.count << " != " << total_acquires << std::endl;
+                    ++ status;
+                }
+                const double jain = (sum_squares > 0) ?
+                    static_cast<double>(total_acquires) * total_acquires / (num_threads * sum_squares) : 0;
+                out << std::setw(8) << lock << std::setw(8) << num_threads << std::setw(8) << cs_lines
+                    << std::setw(14) << total_acquires / max_elapsed_s / 1e6
+                    << std::setw(14) << ((num_handoffs > 0) ? handoff_ticks * ns_per_tick / num_handoffs : 0)
+                    << std::setw(10) << jain
+                    << std::setw(10) << ((max_acquires > 0) ? static_cast<double>(min_acquires) / max_acquires : 0)
+                    << std::endl;
+            }
+        }
+    }
+    utils::end_timer("all", std::cout);
+    std::cout << out.str();
+    return status;
 }
@@ -1,119 +1,210 @@
-#include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <pthread.h>
-#include <sched.h>
-#include <sys/sysinfo.h>
 
-#include "utils/lib_mem_region.hh"
+#include "utils/lib_options.hh"
 #include "utils/lib_timing.hh"
 #include "misc/pthread_rdwr.hh"
 
-// global defined lock
-pthread_mutex_t g_flow_mutex;
-pthread_cond_t  g_flow_cond;
-pthread_rwlock_t g_flow_rwlock;   // probably not necessary
-uint32_t g_flow_step;
-
-// thread function
-void *writer_thread(void *ptr) {
-    const ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
-    std::string thread_sign = "thread " + std::to_string(pkt->getThreadId());
-    // two timers
-    std::string timer_full = thread_sign + " full";
-    std::string timer_work = thread_sign + " work";
-    // start full timer
-    utils::start_timer(timer_full);
-    // write lock
-    pthread_mutex_lock(&g_flow_mutex);
-    pthread_rwlock_wrlock(&g_flow_rwlock);
-    // start work timer
-    utils::start_timer(timer_work);
-    // real work
-    const uint64_t loop_count = 20000000 * 20;
-    double sum = 1;
-    for (uint64_t i = 1; i <= loop_count; ++i) {
-        if (i % 2 == 0) {
-            sum *= static_cast<double>(i);
+template <class RwLock>
+void rw_loop(ThreadPacket* pkt, RwLock& rw_lock)
+{
+    RwSetup* setup = pkt->setup;
+    RwNode node;
+    node.tid = pkt->getThreadId();
+    const bool timekeeper = (node.tid == 0);
+    uint64_t seed = 0x9e3779b97f4a7c15ULL * (node.tid + 1);
+    uint64_t words[Payload::NUM_WORDS];
+    uint64_t num_reads = 0;
+    uint64_t num_writes = 0;
+    uint64_t num_torn = 0;
+    uint64_t num_ops = 0;
+    const auto time_begin = std::chrono::steady_clock::now();
+    while (!setup->stop.load(std::memory_order_relaxed)) {
+        // xorshift decides read or write
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        if (seed % 10000 < setup->write_bp) {
+            const uint64_t t1 = utils::rdtscp();
+            rw_lock.write(node, seed);
+            const uint64_t t2 = utils::rdtscp();
+            pkt->write_hist.add(t2 - t1);
+            ++ num_writes;
         } else {
-            sum /= static_cast<double>(i);
+            rw_lock.read(node, words);
+            for (uint32_t i = 1; i < Payload::NUM_WORDS; ++i) {
+                if (words[i] != words[0]) {
+                    ++ num_torn;
+                    break;
+                }
+            }
+            ++ num_reads;
+        }
+        ++ num_ops;
+        if (timekeeper && (num_ops & 63) == 0 &&
+            std::chrono::steady_clock::now() > setup->deadline) {
+            setup->stop.store(true, std::memory_order_relaxed);
         }
     }
-    // end timer
-    if (sum > 0) {
-        utils::end_timer(timer_full, std::cout);
-        utils::end_timer(timer_work, std::cout);
-    }
-    // unlock
-    ++ g_flow_step;
-    pthread_cond_broadcast(&g_flow_cond);
-    pthread_mutex_unlock(&g_flow_mutex);
-    pthread_rwlock_unlock(&g_flow_rwlock);
-    return NULL;
+    const auto time_end = std::chrono::steady_clock::now();
+    pkt->num_reads = num_reads;
+    pkt->num_writes = num_writes;
+    pkt->num_torn = num_torn;
+    pkt->elapsed_s = std::chrono::duration_cast<std::chrono::duration<double>>(time_end - time_begin).count();
 }
 
-void *reader_thread(void *ptr) {
-    const ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
-    std::string thread_sign = "thread " + std::to_string(pkt->getThreadId());
-    // two timers
-    std::string timer_full = thread_sign + " full";
-    std::string timer_work = thread_sign + " work";
-    // start full timer
-    utils::start_timer(timer_full);
-    // read lock
-    pthread_mutex_lock(&g_flow_mutex);
-    while (g_flow_step == 0) {
-        pthread_cond_wait(&g_flow_cond, &g_flow_mutex);
-    }
-    pthread_mutex_unlock(&g_flow_mutex);
-    pthread_rwlock_rdlock(&g_flow_rwlock);
-    // start work timer
-    utils::start_timer(timer_work);
-    // real work
-    const uint64_t loop_count = 20000000 * 20;
-    double sum = 1;
-    for (uint64_t i = 1; i <= loop_count; ++i) {
-        if (i % 2 == 0) {
-            sum *= static_cast<double>(i);
-        } else {
-            sum /= static_cast<double>(i);
-        }
+// threads beyond this config's count exit at once, so they hold no cpu
+void *thread_rdwr(void *ptr)
+{
+    ThreadPacket* pkt = static_cast<ThreadPacket*>(ptr);
+    RwSetup* setup = pkt->setup;
+    pkt->num_reads = 0;
+    pkt->num_writes = 0;
+    pkt->num_torn = 0;
+    pkt->write_hist.clear();
+    if (pkt->getThreadId() >= setup->num_threads) {
+        return NULL;
     }
-    // end timer
-    if (sum > 0) {
-        utils::end_timer(timer_work, std::cout);
-        utils::end_timer(timer_full, std::cout);
+    switch (setup->rw_type) {
+    case RwType::PTHREAD:
+        rw_loop(pkt, *setup->pthread_lock);
+        break;
+    case RwType::SEQLOCK:
+        rw_loop(pkt, *setup->seq_lock);
+        break;
+    case RwType::BRAVO:
+        rw_loop(pkt, *setup->bravo_lock);
+        break;
+    case RwType::RCU:
+        rw_loop(pkt, *setup->rcu_lock);
+        break;
     }
-    // unlock
-    pthread_rwlock_unlock(&g_flow_rwlock);
     return NULL;
 }
 
+RwType get_rw_type(const std::string& name) {
+    if (name == "pthread") return RwType::PTHREAD;
+    if (name == "seqlock") return RwType::SEQLOCK;
+    if (name == "bravo") return RwType::BRAVO;
+    if (name == "rcu") return RwType::RCU;
+    std::cerr << "unknown scheme: " << name << std::endl;
+    exit(1);
+}
+
 int main(int argc, char **argv)
 {
-    uint32_t thread_step = 1;
-    if (argc > 1) {
-        thread_step = atoi(argv[1]);
+    utils::start_timer("startup");
+    const utils::Options options(argc, argv);
+    // input parameters
+    if (argc < 4) {
+        std::cout << "Usage: ./pthread_rdwr <duration_ms> <max threads> <thread mapping step> <core-id start>" << std::endl;
+        std::cout << "\tread-mostly shoot-out, for 1,2,4,..,max threads; every thread mixes reads and writes" << std::endl;
+        std::cout << "\tthread mapping step: e.g. 2 leads to 0,1,2,3 -> 0,2,1,3" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "\t--scheme=<list>: pthread, seqlock, bravo, rcu; default all" << std::endl;
+        std::cout << "\t--write_bp=<list>: writes per 10000 operations; default 0,10,100,1000" << std::endl;
+        std::cout << "\t--placement=compact|scatter|core|l3|<cpu list>: placement from the cpu topology, overrides the mapping step" << std::endl;
+        std::cout << "Example: ./pthread_rdwr 200 16 1 0 --scheme=pthread,rcu --write_bp=1,100" << std::endl;
+        exit(1);
     }
-    // init locks
-    pthread_rwlock_init(&g_flow_rwlock, NULL);
-    pthread_mutex_init(&g_flow_mutex, NULL);
-    pthread_cond_init(&g_flow_cond, NULL);
-    // thread attrs
-    const uint32_t num_threads = get_nprocs();
-    utils::ThreadHelper<ThreadPacket> threads(num_threads, num_threads, thread_step);
-    // create threads
-    threads.setRoutine(writer_thread, [](const uint32_t& idx) { return idx == 0; });
-    threads.setRoutine(reader_thread, [](const uint32_t& idx) { return idx > 0; });
-    threads.create();
-    // wait threads
-    threads.join();
-    // destroy locks
-    pthread_rwlock_destroy(&g_flow_rwlock);
-    pthread_mutex_destroy(&g_flow_mutex);
-    pthread_cond_destroy(&g_flow_cond);
-
-    return 0;
+    const uint64_t duration_ms = strtoull(argv[1], NULL, 10);
+    const uint32_t num_cores = utils::CpuTopology::get().numCpus();
+    const uint32_t max_threads_user = atoi(argv[2]);
+    const uint32_t max_threads = (max_threads_user > 0) ? max_threads_user : num_cores;
+    const uint32_t thread_step = atoi(argv[3]);
+    uint32_t core_id_start = 0;
+    if (argc >= 5) core_id_start = atoi(argv[4]);
+    std::vector<std::string> schemes;
+    std::stringstream ss(options.get("scheme", "pthread,seqlock,bravo,rcu"));
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        get_rw_type(item);
+        schemes.push_back(item);
+    }
+    std::vector<uint64_t> write_bps = options.getUintList("write_bp");
+    if (write_bps.empty()) {
+        write_bps = {0, 10, 100, 1000};
+    }
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t n = 1; n < max_threads; n *= 2) {
+        thread_counts.push_back(n);
+    }
+    thread_counts.push_back(max_threads);
+    // the schemes under test
+    PthreadRwLock pthread_lock(max_threads);
+    SeqLock seq_lock(max_threads);
+    BravoLock bravo_lock(max_threads);
+    RcuLock rcu_lock(max_threads);
+    RwSetup setup;
+    setup.pthread_lock = &pthread_lock;
+    setup.seq_lock = &seq_lock;
+    setup.bravo_lock = &bravo_lock;
+    setup.rcu_lock = &rcu_lock;
+    // calibrate before any thread spins
+    utils::dump_clock_info(std::cout);
+    // one set of max threads, created anew per config: threads beyond its count
+    // exit at once and the main thread blocks in join, so neither takes a cpu
+    // from the measured threads; the packets persist across configs
+    utils::ThreadHelper<ThreadPacket> threads(utils::CpuTopology::get().getPlacement(
+        options.get("placement"), max_threads, thread_step, core_id_start));
+    for (uint32_t i = 0; i < max_threads; ++i) {
+        threads.getPacket(i).setup = &setup;
+    }
+    threads.setRoutine(thread_rdwr, [](const uint32_t& idx) { return true; });
+    utils::end_timer("startup", std::cout);
+    // run
+    utils::start_timer("all");
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << std::setw(8) << "scheme" << std::setw(8) << "threads" << std::setw(10) << "write_bp"
+        << std::setw(14) << "Mreads/s" << std::setw(12) << "writes/s"
+        << std::setw(14) << "wr_mean(ns)" << std::setw(14) << "wr_p99(ns)" << std::endl;
+    uint32_t status = 0;
+    for (const std::string& scheme : schemes) {
+        for (const uint64_t& write_bp : write_bps) {
+            for (const uint32_t& num_threads : thread_counts) {
+                setup.rw_type = get_rw_type(scheme);
+                setup.num_threads = num_threads;
+                setup.write_bp = write_bp;
+                setup.stop.store(false);
+                setup.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(duration_ms);
+                threads.create();
+                threads.join();
+                const double ns_per_tick = utils::ns_per_tick();
+                // reader throughput, writer latency
+                uint64_t total_reads = 0;
+                uint64_t total_writes = 0;
+                uint64_t total_torn = 0;
+                double max_elapsed_s = 0;
+                utils::LogHistogram write_hist;
+                for (uint32_t i = 0; i < num_threads; ++i) {
+                    const ThreadPacket& pkt = threads.getPacket(i);
+                    total_reads += pkt.num_reads;
+                    total_writes += pkt.num_writes;
+                    total_torn += pkt.num_torn;
+                    max_elapsed_s = std::max(max_elapsed_s, pkt.elapsed_s);
+                    write_hist.merge(pkt.write_hist);
+                }
+                if (total_torn > 0) {
+                    std::cerr << scheme << ": " << total_torn << " torn reads" << std::endl;
+                    ++ status;
+                }
+                out << std::setw(8) << scheme << std::setw(8) << num_threads << std::setw(10) << write_bp
+                    << std::setw(14) << total_reads / max_elapsed_s / 1e6
+                    << std::setw(12) << std::setprecision(0) << total_writes / max_elapsed_s << std::setprecision(2)
+                    << std::setw(14) << write_hist.getMean() * ns_per_tick
+                    << std::setw(14) << write_hist.getPercentile(99) * ns_per_tick << std::endl;
+            }
+        }
+    }
+    utils::end_timer("all", std::cout);
+    std::cout << out.str();
+    return status;
 }
-
@@ -1,7 +1,38 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "utils/lib_histogram.hh"
 #include "utils/lib_threading.hh"
+#include "misc/rwlocks.hh"
+
+enum class RwType { PTHREAD, SEQLOCK, BRAVO, RCU };
+
+// one phase of the pool: a scheme, a write ratio, a thread count
+struct RwSetup {
+    PthreadRwLock* pthread_lock = nullptr;
+    SeqLock* seq_lock = nullptr;
+    BravoLock* bravo_lock = nullptr;
+    RcuLock* rcu_lock = nullptr;
+    RwType rw_type = RwType::PTHREAD;
+    uint32_t num_threads = 0;
+    // writes per 10000 operations
+    uint32_t write_bp = 0;
+    std::chrono::steady_clock::time_point deadline;
+    alignas(64) std::atomic<bool> stop {false};
+};
 
 class ThreadPacket : public utils::BaseThreadPacket {
   public:
     ThreadPacket() = default;
     ~ThreadPacket() = default;
+
+    RwSetup* setup = nullptr;
+    // results of the last phase
+    uint64_t num_reads = 0;
+    uint64_t num_writes = 0;
+    uint64_t num_torn = 0;
+    double elapsed_s = 0;
+    // write latency in ticks
+    utils::LogHistogram write_hist;
 };
@@ -0,0 +1,228 @@
+#ifndef __RWLOCKS_HH__
+#define __RWLOCKS_HH__
+
+#include <atomic>
+#include <cstdint>
+#include <pthread.h>
+
+#include "utils/lib_threading.hh"
+#include "utils/lib_timing.hh"
+#include "misc/locks.hh"
+
+// common interface: read() copies the payload out, write() sets every word
+// of it to one value, so a reader seeing different words caught a torn read;
+// Node carries the thread's slot in the per-thread tables
+
+// one line of read-mostly data, e.g. a config entry
+struct alignas(64) Payload {
+    static const uint32_t NUM_WORDS = 8;
+    std::atomic<uint64_t> words[NUM_WORDS];
+
+    Payload() {
+        for (uint32_t i = 0; i < NUM_WORDS; ++i) words[i].store(0, std::memory_order_relaxed);
+    }
+    void load(uint64_t* out) const {
+        for (uint32_t i = 0; i < NUM_WORDS; ++i) out[i] = words[i].load(std::memory_order_relaxed);
+    }
+    void store(uint64_t value) {
+        for (uint32_t i = 0; i < NUM_WORDS; ++i) words[i].store(value, std::memory_order_relaxed);
+    }
+};
+
+// per-thread flag/epoch, one line each
+struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> value {0};
+};
+
+struct RwNode {
+    uint32_t tid = 0;
+    bool fast = false;
+};
+
+// baseline: every reader updates the shared reader count in the lock word
+class PthreadRwLock {
+  public:
+    explicit PthreadRwLock(uint32_t max_threads) { pthread_rwlock_init(&rwlock_, NULL); }
+    ~PthreadRwLock() { pthread_rwlock_destroy(&rwlock_); }
+
+    void read(RwNode& node, uint64_t* out) {
+        pthread_rwlock_rdlock(&rwlock_);
+        payload_.load(out);
+        pthread_rwlock_unlock(&rwlock_);
+    }
+    void write(RwNode& node, uint64_t value) {
+        pthread_rwlock_wrlock(&rwlock_);
+        payload_.store(value);
+        pthread_rwlock_unlock(&rwlock_);
+    }
+
+  private:
+    pthread_rwlock_t rwlock_;
+    Payload payload_;
+};
+
+// readers never write shared state; they retry if a writer was active
+class SeqLock {
+  public:
+    explicit SeqLock(uint32_t max_threads) { }
+
+    void read(RwNode& node, uint64_t* out) {
+        while (true) {
+            const uint64_t seq = seq_.load(std::memory_order_acquire);
+            if (seq & 1) {
+                utils::cpu_relax();
+                continue;
+            }
+            payload_.load(out);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == seq) {
+                return;
+            }
+        }
+    }
+    void write(RwNode& node, uint64_t value) {
+        TtasLock::Node lock_node;
+        writer_lock_.lock(lock_node);
+        const uint64_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        payload_.store(value);
+        seq_.store(seq + 2, std::memory_order_release);
+        writer_lock_.unlock(lock_node);
+    }
+
+  private:
+    TtasLock writer_lock_;
+    alignas(64) std::atomic<uint64_t> seq_ {0};
+    Payload payload_;
+};
+
+// BRAVO-like: while reader bias is on, readers only raise a flag in their own
+// line; a writer revokes the bias, waits for the flags to drain, and keeps the
+// bias off for a while so that write-heavy phases fall back to the rwlock
+class BravoLock {
+  public:
+    static const uint64_t INHIBIT_MULTIPLIER = 9;
+
+    explicit BravoLock(uint32_t max_threads) :
+        num_slots_ (max_threads),
+        slots_ (alloc_lines<ReaderSlot>(max_threads))
+    {
+        pthread_rwlock_init(&rwlock_, NULL);
+    }
+    ~BravoLock() {
+        pthread_rwlock_destroy(&rwlock_);
+        free(slots_);
+    }
+
+    void read(RwNode& node, uint64_t* out) {
+        readLock_(node);
+        payload_.load(out);
+        readUnlock_(node);
+    }
+    void write(RwNode& node, uint64_t value) {
+        pthread_rwlock_wrlock(&rwlock_);
+        if (rbias_.load(std::memory_order_relaxed)) {
+            const uint64_t begin = utils::rdtscp();
+            rbias_.store(false, std::memory_order_seq_cst);
+            for (uint32_t i = 0; i < num_slots_; ++i) {
+                while (slots_[i].value.load(std::memory_order_acquire) != 0) {
+                    utils::cpu_relax();
+                }
+            }
+            const uint64_t end = utils::rdtscp();
+            inhibit_until_.store(end + (end - begin) * INHIBIT_MULTIPLIER, std::memory_order_relaxed);
+        }
+        payload_.store(value);
+        pthread_rwlock_unlock(&rwlock_);
+    }
+
+  private:
+    void readLock_(RwNode& node) {
+        if (rbias_.load(std::memory_order_relaxed)) {
+            std::atomic<uint64_t>& slot = slots_[node.tid].value;
+            slot.store(1, std::memory_order_seq_cst);
+            if (rbias_.load(std::memory_order_seq_cst)) {
+                node.fast = true;
+                return;
+            }
+            slot.store(0, std::memory_order_release);
+        }
+        pthread_rwlock_rdlock(&rwlock_);
+        node.fast = false;
+        if (!rbias_.load(std::memory_order_relaxed) &&
+            utils::rdtscp() >= inhibit_until_.load(std::memory_order_relaxed)) {
+            rbias_.store(true, std::memory_order_relaxed);
+        }
+    }
+    void readUnlock_(RwNode& node) {
+        if (node.fast) {
+            slots_[node.tid].value.store(0, std::memory_order_release);
+        } else {
+            pthread_rwlock_unlock(&rwlock_);
+        }
+    }
+
+    const uint32_t num_slots_;
+    ReaderSlot* slots_;
+    pthread_rwlock_t rwlock_;
+    alignas(64) std::atomic<bool> rbias_ {true};
+    std::atomic<uint64_t> inhibit_until_ {0};
+    Payload payload_;
+};
+
+// epoch-based RCU: readers announce the global epoch in their own line and
+// follow the current pointer; a writer publishes a new copy, bumps the epoch
+// and waits until no reader is still in an older one before reusing the old
+// copy, so two copies are enough
+class RcuLock {
+  public:
+    explicit RcuLock(uint32_t max_threads) :
+        num_slots_ (max_threads),
+        slots_ (alloc_lines<ReaderSlot>(max_threads)),
+        copies_ (alloc_lines<Payload>(2))
+    {
+        current_.store(&copies_[0]);
+    }
+    ~RcuLock() {
+        free(slots_);
+        free(copies_);
+    }
+
+    void read(RwNode& node, uint64_t* out) {
+        std::atomic<uint64_t>& slot = slots_[node.tid].value;
+        slot.store(epoch_.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+        current_.load(std::memory_order_acquire)->load(out);
+        slot.store(0, std::memory_order_release);
+    }
+    void write(RwNode& node, uint64_t value) {
+        TtasLock::Node lock_node;
+        writer_lock_.lock(lock_node);
+        Payload* old_copy = current_.load(std::memory_order_relaxed);
+        Payload* new_copy = (old_copy == &copies_[0]) ? &copies_[1] : &copies_[0];
+        new_copy->store(value);
+        current_.store(new_copy, std::memory_order_seq_cst);
+        // grace period
+        const uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+        for (uint32_t i = 0; i < num_slots_; ++i) {
+            while (true) {
+                const uint64_t reader_epoch = slots_[i].value.load(std::memory_order_acquire);
+                if (reader_epoch == 0 || reader_epoch >= epoch) {
+                    break;
+                }
+                utils::cpu_relax();
+            }
+        }
+        writer_lock_.unlock(lock_node);
+    }
+
+  private:
+    const uint32_t num_slots_;
+    ReaderSlot* slots_;
+    Payload* copies_;
+    TtasLock writer_lock_;
+    alignas(64) std::atomic<uint64_t> epoch_ {1};
+    alignas(64) std::atomic<Payload*> current_ {nullptr};
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#include "utils/lib_histogram.hh"
+
+int main() {
+
+    auto check = [](const utils::LogHistogram& hist, double p, double expected)->void {
+        const double value = hist.getPercentile(p);
+        std::cout << "p" << p << "=" << value << " expected~" << expected << std::endl;
+        // within the bucket resolution
+        assert(std::fabs(value - expected) <= expected / utils::LogHistogram::NUM_SUBS + 1);
+    };
+
+    // -- uniform 1..10000
+    utils::LogHistogram uniform;
+    for (uint64_t i = 1; i <= 10000; ++i) {
+        uniform.add(i);
+    }
+    assert(uniform.getCount() == 10000);
+    assert(uniform.getMin() == 1 && uniform.getMax() == 10000);
+    check(uniform, 50, 5000);
+    check(uniform, 90, 9000);
+    check(uniform, 99, 9900);
+    uniform.dumpPercentiles(std::cout, 1, "tick");
+
+    // -- bimodal: 90% at 100, 10% at 400
+    utils::LogHistogram bimodal;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        bimodal.add(i % 10 == 0 ? 400 : 100);
+    }
+    check(bimodal, 50, 100);
+    check(bimodal, 89, 100);
+    check(bimodal, 99, 400);
+    bimodal.dumpBuckets(std::cout, 1, "tick");
+
+    // -- merge
+    utils::LogHistogram merged;
+    merged.merge(uniform);
+    merged.merge(bimodal);
+    assert(merged.getCount() == 11000);
+    assert(merged.getMin() == 1 && merged.getMax() == 10000);
+    merged.clear();
+    assert(merged.getCount() == 0 && merged.getPercentile(50) == 0);
+
+    return 0;
+}
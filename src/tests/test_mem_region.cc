@@ -39,6 +39,15 @@ int main() {
             assert(0);
         }
         mem_region->dump();
+        // the chain should be one cycle over all active lines
+        uint64_t num_hops = 0;
+        char** p = mem_region->getStartPoint();
+        do {
+            p = (char**)(*p);
+            ++ num_hops;
+        } while (p != mem_region->getStartPoint() && num_hops <= mem_region->numActiveLines());
+        std::cout << "cycle length=" << num_hops << std::endl;
+        assert(num_hops == mem_region->numActiveLines());
         if (use_hugepage) {
             sleep(4);
         }
@@ -70,5 +79,37 @@ int main() {
     // -- active size
     test({8192, 4096, 4096, 512}, false, utils::MemType::NATIVE, 0, "stride");
 
+    // -- multiple chains, same pattern regardless of # of init threads
+    auto chains = [](uint32_t num_chains, uint32_t init_threads, uint64_t seed)->std::vector<uint64_t> {
+        const uint64_t size = 4 * 1024 * 1024;
+        utils::MemRegion mem_region(size, size, 4096, 64);
+        mem_region.setInitThreads(init_threads);
+        mem_region.setSeed(seed);
+        mem_region.all_random_init(num_chains);
+        assert(mem_region.numChains() == num_chains);
+        // record the chain order as offsets
+        const uint64_t start_addr = reinterpret_cast<uint64_t>(mem_region.getStartPoint());
+        std::vector<uint64_t> offsets;
+        uint64_t num_hops = 0;
+        for (uint32_t c = 0; c < num_chains; ++c) {
+            char** p = mem_region.getChainStartPoint(c);
+            do {
+                offsets.push_back(reinterpret_cast<uint64_t>(p) - start_addr);
+                p = (char**)(*p);
+                ++ num_hops;
+            } while (p != mem_region.getChainStartPoint(c) && num_hops <= mem_region.numActiveLines());
+        }
+        std::cout << "chains=" << num_chains << " init threads=" << init_threads
+            << " hops=" << num_hops << std::endl;
+        assert(num_hops == mem_region.numActiveLines());
+        return offsets;
+    };
+    assert(chains(1, 1, 0) == chains(1, 4, 0));
+    assert(chains(7, 1, 0) == chains(7, 3, 0));
+    assert(chains(1, 1, 0) == chains(32, 2, 0));
+    // -- another seed, another order
+    assert(chains(1, 1, 1) == chains(1, 4, 1));
+    assert(chains(1, 1, 1) != chains(1, 1, 0));
+
     return 0;
 }
@@ -0,0 +1,37 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "utils/lib_perf.hh"
+
+int main()
+{
+    // disabled: nothing opened, nothing printed
+    utils::PerfGroup off(false);
+    assert(!off.isEnabled() && !off.isOpen());
+    off.start();
+    assert(off.stop().empty());
+
+    utils::PerfGroup perf;
+    if (!perf.isOpen()) {
+        std::cout << "perf_event not available, skipped" << std::endl;
+        return 0;
+    }
+    std::cout << (perf.isSoftware() ? "software" : "hardware") << " events" << std::endl;
+    const uint64_t loop_count = 10000000;
+    volatile uint64_t sum = 0;
+    perf.start();
+    for (uint64_t i = 0; i < loop_count; ++i) {
+        sum += i;
+    }
+    const std::vector<double> values = perf.stop();
+    assert(values.size() == perf.getNames().size());
+    // the leader (cycles or task-clock) saw the loop
+    assert(values[0] > 0);
+    perf.dump(std::cout, "loop", values, loop_count);
+    // stopped: nothing more counted
+    const std::vector<double> again = perf.stop();
+    assert(again.empty() || again[0] == values[0]);
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "utils/lib_options.hh"
+#include "utils/lib_report.hh"
+
+static std::string read_file(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+static bool contains(const std::string& str, const std::string& part) {
+    return str.find(part) != std::string::npos;
+}
+
+// as if given on the command line
+static void open_report(const std::string& benchmark, const std::string& arg) {
+    std::string prog = "test_report";
+    std::string option = arg;
+    char* argv[] = {&prog[0], &option[0], NULL};
+    int argc = 2;
+    const utils::Options options(argc, argv);
+    utils::Reporter::get().open(benchmark, options);
+}
+
+int main()
+{
+    // scalar rendering
+    assert(utils::ReportValue(3).text == "3" && !utils::ReportValue(3).quoted);
+    assert(utils::ReportValue(uint64_t(1) << 40).text == "1099511627776");
+    assert(utils::ReportValue(0.5).text == "0.5");
+    assert(utils::ReportValue(true).text == "true");
+    assert(utils::ReportValue(std::nan("")).text == "null");
+    assert(utils::ReportValue("x").quoted && utils::ReportValue(std::string("y")).text == "y");
+    assert(utils::join_list({0, 2, 4}) == "0,2,4" && utils::join_list({}) == "");
+
+    // disabled without --report
+    utils::Reporter& reporter = utils::Reporter::get();
+    assert(!reporter.isEnabled());
+    reporter.add(utils::ResultRecord().metric("x", 1));
+
+    const std::string base = "/tmp/test_report_" + std::to_string(getpid());
+    // json lines: one object per record, common config first, record overrides
+    const std::string json_path = base + ".jsonl";
+    open_report("bench", "--report=" + json_path);
+    assert(reporter.isEnabled());
+    assert(!reporter.getHost().empty() && reporter.getHost()[0].first == "hostname");
+    reporter.config("size_kb", 64);
+    reporter.config("pattern", "allRand");
+    reporter.add(utils::ResultRecord().config("note", "a \"quoted\"\tname").metric("per_ref_ns", 1.5));
+    reporter.add(utils::ResultRecord().config("pattern", "stride").metric("per_ref_ns", 2));
+    reporter.close();
+    std::string json = read_file(json_path);
+    std::vector<std::string> lines;
+    std::stringstream ss(json);
+    std::string line;
+    while (std::getline(ss, line)) {
+        lines.push_back(line);
+    }
+    assert(lines.size() == 2);
+    assert(lines[0].compare(0, 22, "{\"benchmark\":\"bench\",\"") == 0);
+    assert(contains(lines[0], "\"config\":{\"size_kb\":64,\"pattern\":\"allRand\",\"note\":\"a \\\"quoted\\\"\\u0009name\"}"));
+    assert(contains(lines[0], "\"metrics\":{\"per_ref_ns\":1.5}}"));
+    assert(contains(lines[1], "\"config\":{\"size_kb\":64,\"pattern\":\"stride\"}"));
+    assert(contains(lines[1], "\"num_cpus\":"));
+    unlink(json_path.c_str());
+
+    // csv by extension: union of the columns, grouped, quoted as needed
+    const std::string csv_path = base + ".csv";
+    open_report("bench", "--report=" + csv_path);
+    reporter.config("threads", 2);
+    reporter.add(utils::ResultRecord().metric("bw_mbps", 100));
+    reporter.add(utils::ResultRecord().config("cores", "0,1").metric("bw_mbps", 200).metric("wall_bw_mbps", 150));
+    reporter.close();
+    const std::string csv = read_file(csv_path);
+    const std::string header = csv.substr(0, csv.find('\n'));
+    assert(header.compare(0, 25, "benchmark,timestamp,host.") == 0);
+    assert(contains(header, ",config.threads,config.cores,metric.bw_mbps,metric.wall_bw_mbps"));
+    assert(contains(csv, ",2,,100,\n"));
+    assert(contains(csv, ",2,\"0,1\",200,150\n"));
+    unlink(csv_path.c_str());
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "utils/lib_stats.hh"
+
+static bool near(double a, double b) {
+    return std::fabs(a - b) < 1e-6 * std::max(1.0, std::fabs(b));
+}
+
+int main()
+{
+    // summary of a known set
+    const std::vector<double> samples = {4, 2, 5, 1, 3};
+    utils::SampleStats stats = utils::summarize(samples);
+    assert(stats.num_samples == 5 && stats.num_dropped == 0);
+    assert(near(stats.min, 1) && near(stats.median, 3) && near(stats.mean, 3));
+    assert(near(stats.stddev, std::sqrt(2.5)));
+    assert(near(stats.ci95, 2.776 * std::sqrt(2.5) / std::sqrt(5)));
+    // a single sample has no spread
+    stats = utils::summarize({7});
+    assert(stats.num_samples == 1 && near(stats.mean, 7) && stats.ci95 == 0);
+    assert(utils::summarize({}).num_samples == 0);
+
+    // tukey fences drop the far one only when asked
+    const std::vector<double> noisy = {10, 11, 10, 12, 11, 10, 100};
+    assert(utils::summarize(noisy).num_dropped == 0);
+    stats = utils::summarize(noisy, 1.5);
+    assert(stats.num_dropped == 1 && stats.num_samples == 6);
+    assert(near(stats.mean, 64.0 / 6));
+
+    // t table
+    assert(near(utils::t95(1), 12.706) && near(utils::t95(30), 2.042) && near(utils::t95(1000), 1.960));
+    assert(utils::t95(40) < utils::t95(30));
+
+    // fixed count
+    utils::RepeatConfig fixed;
+    fixed.min_reps = fixed.max_reps = 5;
+    utils::Repeater repeater(fixed);
+    uint32_t calls = 0;
+    stats = repeater.collect([&calls]() -> double { return ++ calls; });
+    assert(calls == 5 && repeater.getSamples().size() == 5 && near(stats.mean, 3));
+
+    // until the CI target: constant samples converge at min_reps
+    utils::RepeatConfig target;
+    target.min_reps = 3;
+    target.max_reps = 50;
+    target.target_rel_ci = 0.01;
+    utils::Repeater converging(target);
+    stats = converging.collect([]() -> double { return 42; });
+    assert(converging.getSamples().size() == 3 && stats.ci95 == 0);
+    // alternating samples never converge, so it stops at max_reps
+    calls = 0;
+    utils::Repeater capped(target);
+    stats = capped.collect([&calls]() -> double { return (++ calls % 2) ? 1 : 100; });
+    assert(capped.getSamples().size() == 50);
+
+    // timed kernel
+    utils::RepeatConfig timed;
+    timed.min_reps = timed.max_reps = 3;
+    utils::Repeater timer(timed);
+    volatile uint64_t sum = 0;
+    stats = timer.run([&sum]() { for (uint64_t i = 0; i < 1000000; ++i) sum += i; },
+                      [](double elapsed_time) { return elapsed_time * 1e9; });
+    assert(stats.num_samples == 3 && stats.min > 0);
+    utils::dump_stats(std::cout, "loop", "elapsed(ns)", stats);
+    return 0;
+}
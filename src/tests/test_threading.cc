@@ -0,0 +1,63 @@
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+
+#include "utils/lib_threading.hh"
+
+class CountPacket : public utils::BaseThreadPacket {
+  public:
+    CountPacket() = default;
+    ~CountPacket() = default;
+
+    std::atomic<uint32_t>* total = nullptr;
+    uint32_t runs = 0;
+};
+
+void *count_routine(void *ptr)
+{
+    CountPacket* pkt = static_cast<CountPacket*>(ptr);
+    ++ pkt->runs;
+    ++ (*pkt->total);
+    return NULL;
+}
+
+int main() {
+    const utils::CpuTopology& topology = utils::CpuTopology::get();
+    const uint32_t num_threads = 4;
+    // oversubscribe the first cpu; the pool must still make progress
+    std::vector<uint32_t> core_ids(num_threads, topology.getCpus()[0].cpu);
+    utils::ThreadHelper<CountPacket> threads(core_ids);
+    std::atomic<uint32_t> total(0);
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        threads.getPacket(i).total = &total;
+    }
+    threads.setRoutine(count_routine, [](const uint32_t& idx) { return true; });
+
+    // -- every phase runs every thread exactly once, and is over on return
+    threads.startPool();
+    for (uint32_t phase = 1; phase <= 100; ++phase) {
+        threads.runPhase();
+        assert(total.load() == phase * num_threads);
+    }
+    threads.stopPool();
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        const CountPacket& pkt = threads.getPacket(i);
+        assert(pkt.runs == 100);
+        assert(pkt.getPhaseBegin() >= 0 && pkt.getPhaseEnd() >= pkt.getPhaseBegin());
+    }
+
+    // -- a second pool reuses the same barrier
+    threads.startPool();
+    threads.runPhase();
+    threads.stopPool();
+    assert(total.load() == 101 * num_threads);
+
+    // -- plain create/join still works
+    threads.create();
+    threads.join();
+    assert(total.load() == 102 * num_threads);
+
+    std::cout << "test_threading passed" << std::endl;
+    return 0;
+}
@@ -1,6 +1,10 @@
+#include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <thread>
 
 #include "utils/lib_timing.hh"
 
@@ -36,5 +40,32 @@ int main()
 
     ofs.close();
 
+    // calibrated clocks
+    utils::dump_clock_info(std::cout);
+    const utils::ClockInfo& info = utils::get_clock_info();
+    assert(info.tsc_ghz > 0.1 && info.core_ghz > 0.1);
+    assert(utils::resolve_core_freq(0, std::cout) == static_cast<float>(info.core_ghz));
+    assert(utils::resolve_core_freq(2.5, std::cout) == 2.5f);
+
+    // tsc timers accumulate until cleared, and agree with the steady clock
+    const auto time_begin = std::chrono::steady_clock::now();
+    utils::tsc_start<utils::TSC_USER>();
+    run();
+    const uint64_t ticks = utils::tsc_stop<utils::TSC_USER>();
+    const auto time_end = std::chrono::steady_clock::now();
+    const double elapsed_ns = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(time_end - time_begin).count();
+    assert(ticks > 0 && utils::tsc_ticks<utils::TSC_USER>() == ticks);
+    assert(std::fabs(ticks * utils::ns_per_tick() - elapsed_ns) < 0.1 * elapsed_ns);
+    utils::tsc_start<utils::TSC_USER>();
+    run();
+    const uint64_t more_ticks = utils::tsc_stop<utils::TSC_USER>();
+    assert(utils::tsc_ticks<utils::TSC_USER>() == ticks + more_ticks);
+    // slots are per thread
+    std::thread other([]() { assert(utils::tsc_ticks<utils::TSC_USER>() == 0); });
+    other.join();
+    utils::tsc_clear<utils::TSC_USER>();
+    assert(utils::tsc_ticks<utils::TSC_USER>() == 0);
+    utils::report_ticks("tsc", std::cout, ticks, loop_count, info.core_ghz);
+
     return static_cast<int>(sum);
 }
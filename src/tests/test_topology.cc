@@ -0,0 +1,53 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include "utils/lib_topology.hh"
+
+int main() {
+
+    // -- cpu list parsing
+    const std::vector<uint32_t> list = utils::parse_cpu_list("0-3,8,10-11");
+    assert((list == std::vector<uint32_t>{0, 1, 2, 3, 8, 10, 11}));
+    assert(utils::parse_cpu_list("").empty());
+
+    // -- discovery
+    const utils::CpuTopology& topology = utils::CpuTopology::get();
+    topology.dump(std::cout);
+    const uint32_t num_cpus = topology.numCpus();
+    assert(num_cpus > 0);
+    for (const utils::CpuInfo& info : topology.getCpus()) {
+        assert(topology.isAllowed(info.cpu));
+    }
+
+    // -- policies: right size, allowed, no cpu twice
+    const std::vector<std::string> policies = {"step", "compact", "scatter", "core", "l3"};
+    for (const std::string& policy : policies) {
+        const std::vector<uint32_t> core_ids = topology.getPlacement(policy, 1);
+        assert(core_ids.size() == 1);
+        assert(topology.isAllowed(core_ids[0]));
+    }
+    const std::vector<uint32_t> compact = topology.getPlacement("compact", num_cpus);
+    const std::vector<uint32_t> scatter = topology.getPlacement("scatter", num_cpus);
+    assert(std::set<uint32_t>(compact.begin(), compact.end()).size() == num_cpus);
+    assert(std::set<uint32_t>(scatter.begin(), scatter.end()).size() == num_cpus);
+    // one thread per physical core
+    const std::vector<uint32_t> cores = topology.getPlacement("core", 1);
+    assert(topology.getCpu(cores[0]).smt_index == 0);
+
+    // -- step: same formula as before over the allowed cpus
+    const std::vector<uint32_t> step = topology.getPlacement("step", num_cpus, 1, 0);
+    for (uint32_t i = 0; i < num_cpus; ++i) {
+        assert(step[i] == topology.getCpus()[i].cpu);
+    }
+
+    // -- explicit list
+    const uint32_t first = topology.getCpus()[0].cpu;
+    const std::vector<uint32_t> explicit_ids = topology.getPlacement(std::to_string(first), 1);
+    assert(explicit_ids.size() == 1 && explicit_ids[0] == first);
+
+    std::cout << "test_topology passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "utils/lib_histogram.hh"
+
+namespace utils {
+
+LogHistogram::LogHistogram() :
+    counts_ ((64 - SUB_BITS + 1) * NUM_SUBS, 0)
+{
+    clear();
+}
+
+void LogHistogram::clear() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_ = 0;
+    sum_ = 0;
+    min_ = std::numeric_limits<uint64_t>::max();
+    max_ = 0;
+}
+
+void LogHistogram::merge(const LogHistogram& other) {
+    for (uint32_t i = 0; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    sum_ += other.sum_;
+    if (other.total_ > 0) {
+        if (other.min_ < min_) min_ = other.min_;
+        if (other.max_ > max_) max_ = other.max_;
+    }
+}
+
+uint64_t LogHistogram::bucketLow_(uint32_t idx) {
+    if (idx < NUM_SUBS) {
+        return idx;
+    }
+    const uint32_t msb = idx / NUM_SUBS + SUB_BITS - 1;
+    const uint64_t sub = idx % NUM_SUBS;
+    return (static_cast<uint64_t>(1) << msb) | (sub << (msb - SUB_BITS));
+}
+
+uint64_t LogHistogram::bucketHigh_(uint32_t idx) {
+    if (idx < NUM_SUBS) {
+        return idx;
+    }
+    const uint32_t msb = idx / NUM_SUBS + SUB_BITS - 1;
+    return bucketLow_(idx) + (static_cast<uint64_t>(1) << (msb - SUB_BITS)) - 1;
+}
+
+double LogHistogram::getPercentile(double p) const {
+    if (total_ == 0) {
+        return 0;
+    }
+    // rank of the sample, 1-based
+    uint64_t rank = static_cast<uint64_t>(p / 100 * total_ + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total_) rank = total_;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            // clamp into the observed range
+            double value = 0.5 * (bucketLow_(i) + bucketHigh_(i));
+            if (value < min_) value = min_;
+            if (value > max_) value = max_;
+            return value;
+        }
+    }
+    return max_;
+}
+
+void LogHistogram::dumpPercentiles(std::ostream& os, double scale, const std::string& unit) const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2)
+        << "samples=" << total_
+        << " min(" << unit << ")=" << getMin() * scale
+        << " mean=" << getMean() * scale
+        << " p50=" << getPercentile(50) * scale
+        << " p90=" << getPercentile(90) * scale
+        << " p99=" << getPercentile(99) * scale
+        << " p99.9=" << getPercentile(99.9) * scale
+        << " max=" << getMax() * scale << std::endl;
+    os << out.str();
+}
+
+void LogHistogram::dumpBuckets(std::ostream& os, double scale, const std::string& unit) const {
+    static const uint32_t bar_width = 50;
+    uint64_t max_count = 0;
+    for (const uint64_t& count : counts_) {
+        if (count > max_count) max_count = count;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    for (uint32_t i = 0; i < counts_.size(); ++i) {
+        if (counts_[i] == 0) {
+            continue;
+        }
+        out << "[" << std::setw(10) << bucketLow_(i) * scale << ", " << std::setw(10) << (bucketHigh_(i) + 1) * scale
+            << ") " << unit << " " << std::setw(12) << counts_[i]
+            << std::setw(8) << 100.0 * counts_[i] / total_ << "% "
+            << std::string(bar_width * counts_[i] / max_count, '#') << std::endl;
+    }
+    os << out.str();
+}
+
+}
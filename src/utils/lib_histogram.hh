@@ -0,0 +1,63 @@
+#ifndef __LIB_HISTOGRAM_HH__
+#define __LIB_HISTOGRAM_HH__
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+// log-bucketed histogram: every power of two is split into 2^SUB_BITS
+// linear sub-buckets, i.e. within ~6% relative error for SUB_BITS=4
+class LogHistogram {
+  public:
+    static const uint32_t SUB_BITS = 4;
+    static const uint32_t NUM_SUBS = 1 << SUB_BITS;
+
+    LogHistogram();
+    ~LogHistogram() = default;
+
+    void add(uint64_t value) {
+        ++ counts_[bucketIndex_(value)];
+        ++ total_;
+        sum_ += value;
+        if (value < min_) min_ = value;
+        if (value > max_) max_ = value;
+    }
+    void merge(const LogHistogram& other);
+    void clear();
+
+    uint64_t getCount() const { return total_; }
+    uint64_t getMin() const { return total_ ? min_ : 0; }
+    uint64_t getMax() const { return max_; }
+    double getMean() const { return total_ ? static_cast<double>(sum_) / total_ : 0; }
+    // value at percentile p in [0, 100], mid-point of the bucket
+    double getPercentile(double p) const;
+
+    // values are printed after multiplying by scale, e.g. ns per tick
+    void dumpPercentiles(std::ostream& os, double scale, const std::string& unit) const;
+    void dumpBuckets(std::ostream& os, double scale, const std::string& unit) const;
+
+  private:
+    static uint32_t bucketIndex_(uint64_t value) {
+        if (value < NUM_SUBS) {
+            return value;
+        }
+        const uint32_t msb = 63 - __builtin_clzll(value);
+        const uint32_t sub = (value >> (msb - SUB_BITS)) & (NUM_SUBS - 1);
+        return (msb - SUB_BITS + 1) * NUM_SUBS + sub;
+    }
+    static uint64_t bucketLow_(uint32_t idx);
+    static uint64_t bucketHigh_(uint32_t idx);
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_;
+    uint64_t sum_;
+    uint64_t min_;
+    uint64_t max_;
+};
+
+}
+
+#endif
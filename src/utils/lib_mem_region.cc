@@ -1,11 +1,15 @@
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <thread>
 #include <fcntl.h>      // open
 #include <numa.h>       // numa_*
 #include <numaif.h>     // move_pages
+#include <sched.h>      // sched_*affinity
 #include <unistd.h>     // close
 #include <sys/mman.h>   // mmap
 
@@ -20,12 +24,14 @@ MemRegion::MemRegion(
         uint64_t line_size,
         bool use_hugepage,
         MemType mem_type_region2,
-        uint64_t size_region2) :
+        uint64_t size_region2,
+        int numa_node_region2) :
     size_ (size),
     active_size_ (active_size),
     page_size_ (page_size),
     line_size_ (line_size),
     mem_type_region2_ (mem_type_region2),
+    numa_node_region2_ (numa_node_region2),
     size_region2_ (size_region2),
     num_all_pages_ (size_ / page_size_),
     num_active_pages_ (active_size_ / page_size_),
@@ -47,14 +53,13 @@ MemRegion::MemRegion(
             << " raw_addr=0x" << reinterpret_cast<uint64_t>(raw_addr1_)
             << " end_addr=0x" << reinterpret_cast<uint64_t>(addr1_ + size_region1_)
             << " 4K-page=" << std::dec << raw_size1_ / os_page_size_ << std::endl;
-        memset(addr1_, 0, size_region1_);
+        fill_(addr1_, size_region1_);
     }
     // allocate & init 2nd region
     if (size_region2_ > 0) {
         if (mem_type_region2_ == MemType::NATIVE) {
             addr2_ = allocNative_(size_region2_, raw_addr2_, raw_size2_);
-        } else if (mem_type_region2_ == MemType::REMOTE1 ||
-                   mem_type_region2_ == MemType::REMOTE2) {
+        } else if (mem_type_region2_ != MemType::DEVICE) {
             addr2_ = allocRemote_(size_region2_, raw_addr2_, raw_size2_);
         } else {
             addr2_ = allocDevice_(size_region2_, raw_addr2_, raw_size2_);
@@ -63,10 +68,8 @@ MemRegion::MemRegion(
             << " raw_addr=0x" << reinterpret_cast<uint64_t>(raw_addr2_)
             << " end_addr=0x" << reinterpret_cast<uint64_t>(addr2_ + size_region2_)
             << " 4K-page=" << std::dec << raw_size2_ / os_page_size_ << std::endl;
-        memset(addr2_, 0, size_region2_);
+        fill_(addr2_, size_region2_);
     }
-    // use a fixed seed
-    srand(0);
 }
 
 MemRegion::~MemRegion() {
@@ -84,8 +87,7 @@ MemRegion::~MemRegion() {
             } else {
                 free(raw_addr2_);
             }
-        } else if (mem_type_region2_ == MemType::REMOTE1 ||
-                   mem_type_region2_ == MemType::REMOTE2) {
+        } else if (mem_type_region2_ != MemType::DEVICE) {
             numa_free(raw_addr2_, raw_size2_);
         } else {
             munmap(addr2_, size_region2_);
@@ -130,19 +132,63 @@ char* MemRegion::allocNative_(const uint64_t& size, char*& raw_addr, uint64_t& r
 }
 
 char* MemRegion::allocRemote_(const uint64_t& size, char*& raw_addr, uint64_t& raw_size) {
+    if (numa_available() < 0) {
+        error_("numa is not available");
+    }
+    const bool interleave = (mem_type_region2_ == MemType::INTERLEAVE);
+    int node = 1;
+    if (mem_type_region2_ == MemType::REMOTE2) {
+        node = 2;
+    } else if (mem_type_region2_ == MemType::NODE) {
+        node = numa_node_region2_;
+    }
+    if (!interleave && (node < 0 || node > numa_max_node())) {
+        error_("invalid numa node " + std::to_string(node));
+    }
     char* addr = NULL;
     if (use_hugepage_) {
-        error_("not yet support hugepage on remote node");
+        // bind the hugepage mapping before the first touch places it
+        addr = ((char*)mmap(
+            0x0, size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+            0, 0
+        ));
+        if ((int64_t)addr == (int64_t)-1) {
+            error_("mmap failed for hugepage");
+        }
+        struct bitmask* nodes = numa_allocate_nodemask();
+        if (interleave) {
+            copy_bitmask_to_bitmask(numa_all_nodes_ptr, nodes);
+        } else {
+            numa_bitmask_setbit(nodes, node);
+        }
+        if (mbind(addr, size, interleave ? MPOL_INTERLEAVE : MPOL_BIND,
+                  nodes->maskp, nodes->size + 1, 0) != 0) {
+            error_("mbind failed for hugepage");
+        }
+        numa_free_nodemask(nodes);
+        raw_addr = addr;
+        raw_size = size;
+        std::cout << "remote hugepage" << std::endl;
     } else {
         raw_size = size + os_page_size_;
-        if (mem_type_region2_ == MemType::REMOTE2) {
-            raw_addr = (char*)numa_alloc_onnode(raw_size, 2);
+        if (interleave) {
+            raw_addr = (char*)numa_alloc_interleaved(raw_size);
         } else {
-            raw_addr = (char*)numa_alloc_onnode(raw_size, 1);
+            raw_addr = (char*)numa_alloc_onnode(raw_size, node);
+        }
+        if (raw_addr == NULL) {
+            error_("numa alloc failed");
         }
         addr = raw_addr + os_page_size_ - (uint64_t)raw_addr % os_page_size_;
         std::cout << "remote numa_malloc" << std::endl;
     }
+    if (interleave) {
+        std::cout << "interleaved over all nodes" << std::endl;
+    } else {
+        std::cout << "on node " << node << std::endl;
+    }
     return addr;
 }
 
@@ -173,6 +219,13 @@ char* MemRegion::allocDevice_(const uint64_t& size, char*& raw_addr, uint64_t& r
     return addr;
 }
 
+// splitmix64 finalizer; also the per-region PRNG step
+static inline uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
 void MemRegion::randomizeSequence_(
     std::vector<uint64_t>& sequence, uint64_t size, uint64_t unit, bool in_order)
 {
@@ -184,15 +237,16 @@ void MemRegion::randomizeSequence_(
       return;
     }
     // randomize by swapping
-    uint64_t r = rand() ^ (rand() << 10);
+    uint64_t state = seed_;
     for (uint64_t i = size-1; i> 0; --i) {
-        r = (r << 1) ^ rand();
-        uint64_t tmp = sequence[r % (i+1)];
-        sequence[r % (i+1)] = sequence[i];
+        state += 0x9e3779b97f4a7c15ULL;
+        const uint64_t r = mix64(state) % (i+1);
+        uint64_t tmp = sequence[r];
+        sequence[r] = sequence[i];
         sequence[i] = tmp;
     }
     // start should still be start
-    for (uint32_t i = 1; i < size; ++i) {
+    for (uint64_t i = 1; i < size; ++i) {
         if (sequence[i] == 0) {
             sequence[i] = sequence[0];
             sequence[0] = 0;
@@ -201,6 +255,120 @@ void MemRegion::randomizeSequence_(
     }
 }
 
+// pseudo-random permutation of [0, n) computed per index: a 4-round Feistel
+// network over the next even power of two, cycle-walking back into range;
+// rotated so that index 0 maps to 0, i.e. start is still start;
+// the width, round keys and rotation are set up once per init
+class Permutation {
+  public:
+    Permutation(uint64_t n, uint64_t seed) : n_ (n) {
+        while ((static_cast<uint64_t>(1) << (2 * half_bits_)) < n) {
+            ++ half_bits_;
+        }
+        mask_ = (static_cast<uint64_t>(1) << half_bits_) - 1;
+        for (uint64_t round = 0; round < 4; ++round) {
+            keys_[round] = mix64(seed + round);
+        }
+        offset_ = n_ - feistel_(0);
+    }
+
+    uint64_t operator()(uint64_t idx) const {
+        const uint64_t x = feistel_(idx) + offset_;
+        return (x >= n_) ? x - n_ : x;
+    }
+
+  private:
+    uint64_t feistel_(uint64_t x) const {
+        do {
+            uint64_t l = x >> half_bits_;
+            uint64_t r = x & mask_;
+            for (uint64_t round = 0; round < 4; ++round) {
+                const uint64_t t = l ^ (mix64(r ^ keys_[round]) & mask_);
+                l = r;
+                r = t;
+            }
+            x = (l << half_bits_) | r;
+        } while (x >= n_);
+        return x;
+    }
+
+    const uint64_t n_;
+    uint32_t half_bits_ = 1;
+    uint64_t mask_;
+    uint64_t keys_[4];
+    // n - feistel(0), in (0, n]
+    uint64_t offset_;
+};
+
+// cpus of the caller's current NUMA node, within the caller's affinity;
+// workers touching pages from there keep first-touch placement unchanged
+static void get_local_cpus(cpu_set_t& cpuset) {
+    CPU_ZERO(&cpuset);
+    sched_getaffinity(0, sizeof(cpu_set_t), &cpuset);
+    if (numa_available() < 0) {
+        return;
+    }
+    const int node = numa_node_of_cpu(sched_getcpu());
+    struct bitmask* node_cpus = numa_allocate_cpumask();
+    if (node >= 0 && numa_node_to_cpus(node, node_cpus) == 0) {
+        cpu_set_t local;
+        CPU_ZERO(&local);
+        for (uint32_t cpu = 0; cpu < node_cpus->size && cpu < CPU_SETSIZE; ++cpu) {
+            if (numa_bitmask_isbitset(node_cpus, cpu) && CPU_ISSET(cpu, &cpuset)) {
+                CPU_SET(cpu, &local);
+            }
+        }
+        if (CPU_COUNT(&local) > 0) {
+            cpuset = local;
+        }
+    }
+    numa_free_cpumask(node_cpus);
+}
+
+// split [0, n) into contiguous ranges over worker threads on the local node;
+// ranges smaller than min_chunk are not worth a thread
+void MemRegion::parallelFor_(
+    uint64_t n, uint64_t min_chunk, const std::function<void(uint64_t, uint64_t)>& func) const
+{
+    cpu_set_t cpuset;
+    get_local_cpus(cpuset);
+    uint64_t num_threads = (init_threads_ > 0) ? init_threads_ : CPU_COUNT(&cpuset);
+    num_threads = std::min<uint64_t>(num_threads, std::max<uint64_t>(1, n / std::max<uint64_t>(min_chunk, 1)));
+    if (num_threads <= 1) {
+        func(0, n);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (uint64_t t = 0; t < num_threads; ++t) {
+        const uint64_t begin = n * t / num_threads;
+        const uint64_t end = n * (t + 1) / num_threads;
+        workers.push_back(std::thread([&cpuset, &func, begin, end]() {
+            sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
+            func(begin, end);
+        }));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// zero-fill, also the first touch of every page
+void MemRegion::fill_(char* addr, uint64_t size) {
+    parallelFor_(size / os_page_size_, 16384, [this, addr](uint64_t begin, uint64_t end) {
+        memset(addr + begin * os_page_size_, 0, (end - begin) * os_page_size_);
+    });
+    const uint64_t tail = size % os_page_size_;
+    memset(addr + size - tail, 0, tail);
+}
+
+void MemRegion::setActiveSize(uint64_t active_size) {
+    if (active_size > size_ || active_size < page_size_) {
+        error_("active size should be within [page size, total size]");
+    }
+    active_size_ = active_size;
+    num_active_pages_ = active_size_ / page_size_;
+}
+
 char* MemRegion::getOffsetAddr_(uint64_t offset) const {
     if (size_region1_ > 0 && offset < size_region1_) {
         return &addr1_[offset];
@@ -210,59 +378,76 @@ char* MemRegion::getOffsetAddr_(uint64_t offset) const {
     }
 }
 
-// create a circular list of pointers with sequential stride
-void MemRegion::stride_init()
+// link the lines in chain order into num_chains disjoint circular lists;
+// offset_of(i) gives the byte offset of the i-th line in chain order
+template <class OffsetFunc>
+void MemRegion::linkChains_(uint64_t num_lines, uint32_t num_chains, OffsetFunc offset_of)
 {
-    uint64_t i = 0;
-    for (i = line_size_; i < active_size_; i += line_size_) {
-        *(char**)getOffsetAddr_(i - line_size_) = (char*)getOffsetAddr_(i);
+    if (num_chains == 0 || num_chains > num_lines) {
+        error_("number of chains should be within [1, # of active lines]");
+    }
+    chain_starts_.assign(num_chains, NULL);
+    for (uint32_t c = 0; c < num_chains; ++c) {
+        const uint64_t begin = num_lines * c / num_chains;
+        const uint64_t end = num_lines * (c + 1) / num_chains;
+        parallelFor_(end - 1 - begin, 65536, [this, begin, &offset_of](uint64_t b, uint64_t e) {
+            uint64_t next = offset_of(begin + b);
+            for (uint64_t i = begin + b; i < begin + e; ++i) {
+                const uint64_t curr = next;
+                next = offset_of(i + 1);
+                *(char**)getOffsetAddr_(curr) = (char*)getOffsetAddr_(next);
+            }
+        });
+        // close the cycle
+        *(char**)getOffsetAddr_(offset_of(end - 1)) = (char*)getOffsetAddr_(offset_of(begin));
+        chain_starts_[c] = (char**)getOffsetAddr_(offset_of(begin));
     }
-    *(char**)getOffsetAddr_(i - line_size_) = (char*)getOffsetAddr_(0);
+}
+
+// create a circular list of pointers with sequential stride
+void MemRegion::stride_init(uint32_t num_chains)
+{
+    const uint64_t line_size = line_size_;
+    linkChains_(active_size_ / line_size_, num_chains,
+                [line_size](uint64_t i) { return i * line_size; });
 }
 
 // create a circular list of pointers with random-in-page
-void MemRegion::page_random_init()
+void MemRegion::page_random_init(uint32_t num_chains)
 {
     std::vector<uint64_t> pages_(num_active_pages_, 0);
     std::vector<uint64_t> linesInPage_(num_lines_in_page_, 0);
     randomizeSequence_(pages_, num_active_pages_, page_size_, true);
     randomizeSequence_(linesInPage_, num_lines_in_page_, line_size_);
-    // run through the pages
-    for (uint64_t i = 0; i < num_active_pages_; ++i) {
-        // run through the lines within a page
-        for (uint64_t j = 0; j < num_lines_in_page_ - 1; ++j) {
-            *(char**)getOffsetAddr_(pages_.at(i) + linesInPage_.at(j))
-                = (char*)getOffsetAddr_(pages_.at(i) + linesInPage_.at(j + 1));
-        }
-        // jump the next page
-        uint64_t next_page = (i == num_active_pages_ - 1) ? 0 : (i + 1);
-        *(char**)getOffsetAddr_(pages_.at(i) + linesInPage_.at(num_lines_in_page_ - 1))
-            = (char*)getOffsetAddr_(pages_.at(next_page) + linesInPage_.at(0));
-    }
+    // run through the pages, and the lines within a page
+    const uint64_t num_lines_in_page = num_lines_in_page_;
+    linkChains_(numActiveLines(), num_chains,
+                [&pages_, &linesInPage_, num_lines_in_page](uint64_t i) {
+                    return pages_[i / num_lines_in_page] + linesInPage_[i % num_lines_in_page];
+                });
 }
 
 // create a circular list of pointers with all-random
-void MemRegion::all_random_init()
+void MemRegion::all_random_init(uint32_t num_chains)
 {
     const uint64_t num_lines = numActiveLines();
-    std::vector<uint64_t> lines_(num_lines, 0);
-    randomizeSequence_(lines_, num_lines, line_size_);
+    const uint64_t line_size = line_size_;
+    const Permutation permute(num_lines, seed_);
     // run through the lines
-    for (uint64_t i = 0; i < num_lines - 1; ++i) {
-        *(char**)getOffsetAddr_(lines_.at(i)) = (char*)getOffsetAddr_(lines_.at(i + 1));
-    }
-    *(char**)getOffsetAddr_(lines_.at(num_lines - 1)) = (char*)getOffsetAddr_(lines_.at(0));
+    linkChains_(num_lines, num_chains, [&permute, line_size](uint64_t i) {
+        return permute(i) * line_size;
+    });
 }
 
 // migrate pages to another node
 void MemRegion::migratePages_(char*& addr, uint64_t size, int target_node)
 {
     const bool verbose = true;
-    uint32_t num_os_pages = size / os_page_size_;
+    uint64_t num_os_pages = size / os_page_size_;
     void** pages = (void**)malloc(sizeof(char*) * num_os_pages);
     int* nodes = (int*)malloc(sizeof(int*) * num_os_pages);
     int* status = (int*)malloc(sizeof(int*) * num_os_pages);
-    for (uint32_t i = 0; i < num_os_pages; ++i) {
+    for (uint64_t i = 0; i < num_os_pages; ++i) {
         pages[i] = addr + i * os_page_size_;
         nodes[i] = target_node;
         status[i] = 0;
@@ -273,7 +458,7 @@ void MemRegion::migratePages_(char*& addr, uint64_t size, int target_node)
         std::cout << "Page migration failed with retcode=" << ret << std::endl;
     }
     if (verbose || ret != 0) {
-        for (uint32_t i = 0; i < num_os_pages; ++i) {
+        for (uint64_t i = 0; i < num_os_pages; ++i) {
             bool to_print = (status[i] < 0 || status[i] != target_node ||
                              i <= 2 || i >= num_os_pages - 2);
             if (to_print) {
@@ -2,7 +2,9 @@
 #define __LIB_MEM_H__
 
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace utils {
@@ -12,6 +14,8 @@ enum class MemType : char {
   REMOTE1,
   REMOTE2,
   DEVICE,
+  NODE,         // a chosen NUMA node
+  INTERLEAVE,   // round-robin over all NUMA nodes
 };
 
 
@@ -26,20 +30,31 @@ class MemRegion {
       uint64_t line_size,
       bool use_hugepage=false,
       MemType mem_type_region2=MemType::NATIVE,
-      uint64_t size_region2=0);
+      uint64_t size_region2=0,
+      int numa_node_region2=-1);
     virtual ~MemRegion();
 
-    // initialize to different patterns
-    void stride_init();
-    void page_random_init();
-    void all_random_init();
+    // initialize to different patterns; the chain can be split into
+    // multiple disjoint circular lists of (almost) equal length;
+    // random patterns only depend on the seed, not on the # of init threads
+    void stride_init(uint32_t num_chains=1);
+    void page_random_init(uint32_t num_chains=1);
+    void all_random_init(uint32_t num_chains=1);
+    void setSeed(uint64_t seed) { seed_ = seed; }
+    // 0: all cpus of the caller's NUMA node
+    void setInitThreads(uint32_t num_threads) { init_threads_ = num_threads; }
     // helper
     void dump();
     uint64_t numAllLines() const { return num_all_pages_ * num_lines_in_page_; }
     uint64_t numActiveLines() const { return num_active_pages_ * num_lines_in_page_; }
+    // shrink/grow the active prefix within the allocated size; re-init the pattern afterwards
+    void setActiveSize(uint64_t active_size);
+    uint64_t getActiveSize() const { return active_size_; }
     // entry point
     char** getStartPoint() const { return (char**)getOffsetAddr_(0); }
     char** getHalfPoint() const { return (char**)getOffsetAddr_(active_size_ / 2); }
+    uint32_t numChains() const { return chain_starts_.size(); }
+    char** getChainStartPoint(uint32_t idx) const { return chain_starts_.at(idx); }
     // migrate pages
     void migrate(int target_node);
 
@@ -53,7 +68,11 @@ class MemRegion {
         uint64_t size,
         uint64_t unit,
         bool in_order=false);
+    void parallelFor_(uint64_t n, uint64_t min_chunk, const std::function<void(uint64_t, uint64_t)>& func) const;
+    void fill_(char* addr, uint64_t size);
     char* getOffsetAddr_(uint64_t offset) const;
+    template <class OffsetFunc>
+    void linkChains_(uint64_t num_lines, uint32_t num_chains, OffsetFunc offset_of);
     void migratePages_(char*& addr, uint64_t size, int target_node);
 
     uint64_t size_;         // size of memory region in Bytes
@@ -63,6 +82,7 @@ class MemRegion {
     uint64_t line_size_;    // not necessarily the cacheline size; i.e. preferred spatial stride
     bool use_hugepage_ = false;
     MemType mem_type_region2_ = MemType::NATIVE;
+    int numa_node_region2_ = -1;
     uint64_t size_region1_;
     uint64_t size_region2_;
 
@@ -77,6 +97,10 @@ class MemRegion {
     uint64_t num_all_pages_;
     uint64_t num_active_pages_;
     uint64_t num_lines_in_page_;
+
+    uint64_t seed_ = 0;
+    uint32_t init_threads_ = 0;
+    std::vector<char**> chain_starts_;
 };
 
 }
@@ -0,0 +1,60 @@
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "utils/lib_options.hh"
+
+namespace utils {
+
+Options::Options(int& argc, char** argv) {
+    int num_positional = 0;
+    for (int i = 0; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i > 0 && arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            const size_t pos = arg.find('=');
+            if (pos == std::string::npos) {
+                options_[arg.substr(2)] = "";
+            } else {
+                options_[arg.substr(2, pos - 2)] = arg.substr(pos + 1);
+            }
+        } else {
+            argv[num_positional++] = argv[i];
+        }
+    }
+    argc = num_positional;
+}
+
+std::string Options::get(const std::string& key, const std::string& default_value) const {
+    auto it = options_.find(key);
+    return (it == options_.end()) ? default_value : it->second;
+}
+
+uint64_t Options::getUint(const std::string& key, uint64_t default_value) const {
+    auto it = options_.find(key);
+    if (it == options_.end() || it->second.empty()) {
+        return default_value;
+    }
+    return std::strtoull(it->second.c_str(), NULL, 10);
+}
+
+double Options::getDouble(const std::string& key, double default_value) const {
+    auto it = options_.find(key);
+    if (it == options_.end() || it->second.empty()) {
+        return default_value;
+    }
+    return std::atof(it->second.c_str());
+}
+
+std::vector<uint64_t> Options::getUintList(const std::string& key) const {
+    std::vector<uint64_t> values;
+    std::stringstream ss(get(key));
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(std::strtoull(item.c_str(), NULL, 10));
+        }
+    }
+    return values;
+}
+
+}
@@ -0,0 +1,31 @@
+#ifndef __LIB_OPTIONS_HH__
+#define __LIB_OPTIONS_HH__
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+// optional "--key=value" / "--key" arguments mixed with the positional ones;
+// they are stripped from argv so the positional parsing stays unchanged
+class Options {
+  public:
+    Options(int& argc, char** argv);
+    ~Options() = default;
+
+    bool has(const std::string& key) const { return options_.count(key) > 0; }
+    std::string get(const std::string& key, const std::string& default_value="") const;
+    uint64_t getUint(const std::string& key, uint64_t default_value=0) const;
+    double getDouble(const std::string& key, double default_value=0) const;
+    // comma-separated list, e.g. --mlp=1,2,4,8
+    std::vector<uint64_t> getUintList(const std::string& key) const;
+
+  private:
+    std::map<std::string, std::string> options_;
+};
+
+}
+
+#endif
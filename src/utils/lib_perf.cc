@@ -0,0 +1,154 @@
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "utils/lib_perf.hh"
+
+namespace utils {
+
+static int perf_event_open(struct perf_event_attr* attr, pid_t pid, int cpu, int group_fd, unsigned long flags) {
+    return syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+static uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+PerfGroup::PerfGroup(bool enabled) :
+    enabled_ (enabled),
+    software_ (false)
+{
+    if (!enabled_) {
+        return;
+    }
+    if (open_(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles")) {
+        open_(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions");
+        open_(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D,
+            PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), "L1D-miss");
+        open_(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL,
+            PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), "LLC-miss");
+        open_(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_DTLB,
+            PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), "dTLB-miss");
+        open_(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_NODE,
+            PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS), "remote-miss");
+        // more events than counters leaves the whole group unscheduled;
+        // drop from the tail until a trial run counts
+        while (fds_.size() > 1) {
+            start();
+            if (!stop().empty()) {
+                break;
+            }
+            close(fds_.back());
+            fds_.pop_back();
+            names_.pop_back();
+        }
+    }
+    if (!isOpen()) {
+        software_ = true;
+        if (open_(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "task-clock(ns)")) {
+            open_(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "page-faults");
+            open_(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context-switches");
+            open_(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS, "cpu-migrations");
+        } else {
+            std::cerr << "perf_event_open failed: " << strerror(errno) << "; no counters" << std::endl;
+        }
+    }
+}
+
+PerfGroup::~PerfGroup() {
+    close_();
+}
+
+bool PerfGroup::open_(uint32_t type, uint64_t config, const std::string& name) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(struct perf_event_attr));
+    attr.type = type;
+    attr.size = sizeof(struct perf_event_attr);
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = fds_.empty() ? 1 : 0;
+    // user space only, so it works at perf_event_paranoid=2
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // calling thread, any cpu
+    const int fd = perf_event_open(&attr, 0, -1, fds_.empty() ? -1 : fds_[0], 0);
+    if (fd < 0) {
+        return false;
+    }
+    fds_.push_back(fd);
+    names_.push_back(name);
+    return true;
+}
+
+void PerfGroup::close_() {
+    // members before the leader
+    for (uint32_t i = fds_.size(); i > 0; --i) {
+        close(fds_[i - 1]);
+    }
+    fds_.clear();
+    names_.clear();
+}
+
+void PerfGroup::start() {
+    if (isOpen()) {
+        ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+std::vector<double> PerfGroup::stop() {
+    std::vector<double> values;
+    if (!isOpen()) {
+        return values;
+    }
+    ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    // nr, time enabled, time running, then one value per event
+    std::vector<uint64_t> buffer(3 + fds_.size());
+    const ssize_t size = read(fds_[0], buffer.data(), buffer.size() * sizeof(uint64_t));
+    if (size < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buffer[2] == 0) {
+        return values;
+    }
+    const double scale = static_cast<double>(buffer[1]) / buffer[2];
+    for (uint64_t i = 0; i < buffer[0] && i < fds_.size(); ++i) {
+        values.push_back(buffer[3 + i] * scale);
+    }
+    return values;
+}
+
+void PerfGroup::dump(std::ostream& os, const std::string& tag, const std::vector<double>& values, uint64_t num_refs) const {
+    if (!enabled_) {
+        return;
+    }
+    std::ostringstream out;
+    out << "perf <" << tag << ">:";
+    if (values.empty()) {
+        out << " n/a" << std::endl;
+        os << out.str();
+        return;
+    }
+    out << std::fixed << std::setprecision(0);
+    for (uint32_t i = 0; i < values.size() && i < names_.size(); ++i) {
+        out << " " << names_[i] << "=" << values[i];
+    }
+    // hardware groups lead with cycles
+    if (!software_ && values.size() >= 2 && names_[1] == "instructions" && values[0] > 0) {
+        out << std::setprecision(3) << " IPC=" << values[1] / values[0];
+    }
+    out << std::endl;
+    if (num_refs > 0) {
+        out << "perf <" << tag << "> per-ref:" << std::setprecision(3);
+        for (uint32_t i = 0; i < values.size() && i < names_.size(); ++i) {
+            out << " " << names_[i] << "=" << values[i] / num_refs;
+        }
+        out << std::endl;
+    }
+    os << out.str();
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef __LIB_PERF_HH__
+#define __LIB_PERF_HH__
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+// a group of counting events on the calling thread, read in one go:
+// cycles, instructions, L1D/LLC/dTLB read misses and remote-node misses;
+// events the PMU (or perf_event_paranoid) refuses are dropped, and without
+// a cycles leader the group falls back to software events;
+// a disabled group (e.g. without --perf) opens nothing and prints nothing
+class PerfGroup {
+  public:
+    explicit PerfGroup(bool enabled=true);
+    ~PerfGroup();
+    PerfGroup(const PerfGroup&) = delete;
+    PerfGroup& operator=(const PerfGroup&) = delete;
+
+    bool isEnabled() const { return enabled_; }
+    bool isOpen() const { return !fds_.empty(); }
+    bool isSoftware() const { return software_; }
+    const std::vector<std::string>& getNames() const { return names_; }
+
+    // reset & enable
+    void start();
+    // counts since start(), scaled up if the group was multiplexed;
+    // empty if it never got onto the PMU
+    std::vector<double> stop();
+
+    // perf <tag>: name=value ..., plus the counts per ref if num_refs > 0
+    void dump(std::ostream& os, const std::string& tag, const std::vector<double>& values, uint64_t num_refs=0) const;
+
+  private:
+    bool open_(uint32_t type, uint64_t config, const std::string& name);
+    void close_();
+
+    std::vector<int> fds_;
+    std::vector<std::string> names_;
+    bool enabled_;
+    bool software_;
+};
+
+}
+
+#endif
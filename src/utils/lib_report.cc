@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <set>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include "utils/lib_report.hh"
+#include "utils/lib_timing.hh"
+#include "utils/lib_topology.hh"
+
+namespace utils {
+
+ResultRecord& ResultRecord::config(const std::string& key, const ReportValue& value) {
+    config_.emplace_back(key, value);
+    return *this;
+}
+
+ResultRecord& ResultRecord::metric(const std::string& key, const ReportValue& value) {
+    metrics_.emplace_back(key, value);
+    return *this;
+}
+
+ResultRecord& ResultRecord::stats(const std::string& prefix, const SampleStats& stats) {
+    metric(prefix + "_n", stats.num_samples);
+    metric(prefix + "_dropped", stats.num_dropped);
+    metric(prefix + "_min", stats.min);
+    metric(prefix + "_median", stats.median);
+    metric(prefix + "_mean", stats.mean);
+    metric(prefix + "_stddev", stats.stddev);
+    metric(prefix + "_ci95", stats.ci95);
+    return *this;
+}
+
+std::string join_list(const std::vector<uint32_t>& list) {
+    std::ostringstream out;
+    for (uint32_t i = 0; i < list.size(); ++i) {
+        out << (i ? "," : "") << list[i];
+    }
+    return out.str();
+}
+
+static std::string json_escape(const std::string& str) {
+    std::string escaped;
+    for (const char& c : str) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            escaped += buffer;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static std::string json_value(const ReportValue& value) {
+    return value.quoted ? "\"" + json_escape(value.text) + "\"" : value.text;
+}
+
+static std::string json_object(const ReportFields& fields) {
+    std::string out = "{";
+    for (uint32_t i = 0; i < fields.size(); ++i) {
+        out += (i ? "," : "");
+        out += "\"" + json_escape(fields[i].first) + "\":" + json_value(fields[i].second);
+    }
+    return out + "}";
+}
+
+static std::string csv_value(const ReportValue& value) {
+    if (value.text.find_first_of(",\"\n") == std::string::npos) {
+        return value.text;
+    }
+    std::string quoted = "\"";
+    for (const char& c : value.text) {
+        quoted += c;
+        if (c == '"') quoted += '"';
+    }
+    return quoted + "\"";
+}
+
+// UTC, e.g. 2024-01-31T12:00:00Z
+static std::string timestamp() {
+    const time_t now = time(NULL);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    char buffer[32];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return buffer;
+}
+
+static std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            const size_t pos = line.find(':');
+            if (pos != std::string::npos && pos + 2 <= line.size()) {
+                return line.substr(pos + 2);
+            }
+        }
+    }
+    return "";
+}
+
+Reporter& Reporter::get() {
+    static Reporter reporter;
+    return reporter;
+}
+
+Reporter::~Reporter() {
+    close();
+}
+
+void Reporter::open(const std::string& benchmark, const Options& options) {
+    close();
+    benchmark_ = benchmark;
+    common_.clear();
+    rows_.clear();
+    path_ = options.get("report");
+    if (path_.empty()) {
+        return;
+    }
+    const std::string default_format =
+        (path_.size() > 4 && path_.compare(path_.size() - 4, 4, ".csv") == 0) ? "csv" : "jsonl";
+    const std::string format = options.get("report_format", default_format);
+    if (format != "jsonl" && format != "csv") {
+        std::cerr << "unknown report format: " << format << std::endl;
+        exit(1);
+    }
+    csv_ = (format == "csv");
+    if (path_ != "-") {
+        file_.open(path_);
+        if (!file_) {
+            std::cerr << "failed to open report file " << path_ << std::endl;
+            exit(1);
+        }
+    }
+    enabled_ = true;
+    // host: identity, topology, clocks
+    char hostname[256] = {0};
+    gethostname(hostname, sizeof(hostname) - 1);
+    struct utsname uts;
+    uname(&uts);
+    const CpuTopology& topology = CpuTopology::get();
+    std::set<uint32_t> packages;
+    std::set<uint32_t> l3s;
+    std::set<int32_t> nodes;
+    std::set<std::pair<uint32_t, uint32_t>> cores;
+    for (const CpuInfo& info : topology.getCpus()) {
+        packages.insert(info.package_id);
+        l3s.insert(info.l3_id);
+        nodes.insert(info.node_id);
+        cores.insert(std::make_pair(info.package_id, info.core_id));
+    }
+    std::vector<uint32_t> cpus;
+    for (const CpuInfo& info : topology.getCpus()) {
+        cpus.push_back(info.cpu);
+    }
+    const ClockInfo& clock = get_clock_info();
+    host_.clear();
+    host_.emplace_back("hostname", std::string(hostname));
+    host_.emplace_back("kernel", std::string(uts.release));
+    host_.emplace_back("cpu_model", cpu_model());
+    host_.emplace_back("cpus", join_list(cpus));
+    host_.emplace_back("num_cpus", topology.numCpus());
+    host_.emplace_back("num_cores", static_cast<uint32_t>(cores.size()));
+    host_.emplace_back("num_l3s", static_cast<uint32_t>(l3s.size()));
+    host_.emplace_back("num_packages", static_cast<uint32_t>(packages.size()));
+    host_.emplace_back("num_nodes", static_cast<uint32_t>(nodes.size()));
+    host_.emplace_back("invariant_tsc", clock.invariant_tsc);
+    host_.emplace_back("tsc_ghz", clock.tsc_ghz);
+    host_.emplace_back("core_ghz", clock.core_ghz);
+}
+
+void Reporter::config(const std::string& key, const ReportValue& value) {
+    for (auto& field : common_) {
+        if (field.first == key) {
+            field.second = value;
+            return;
+        }
+    }
+    common_.emplace_back(key, value);
+}
+
+void Reporter::add(const ResultRecord& record) {
+    if (!enabled_) {
+        return;
+    }
+    // the record's own config overrides the common one
+    ReportFields config = common_;
+    for (const auto& field : record.getConfig()) {
+        auto it = config.begin();
+        while (it != config.end() && it->first != field.first) {
+            ++ it;
+        }
+        if (it != config.end()) {
+            it->second = field.second;
+        } else {
+            config.push_back(field);
+        }
+    }
+    if (!csv_) {
+        std::string line = "{\"benchmark\":" + json_value(benchmark_);
+        line += ",\"timestamp\":" + json_value(timestamp());
+        line += ",\"host\":" + json_object(host_);
+        line += ",\"config\":" + json_object(config);
+        line += ",\"metrics\":" + json_object(record.getMetrics()) + "}\n";
+        write_(line);
+        return;
+    }
+    ReportFields row;
+    row.emplace_back("benchmark", benchmark_);
+    row.emplace_back("timestamp", timestamp());
+    for (const auto& field : host_) {
+        row.emplace_back("host." + field.first, field.second);
+    }
+    for (const auto& field : config) {
+        row.emplace_back("config." + field.first, field.second);
+    }
+    for (const auto& field : record.getMetrics()) {
+        row.emplace_back("metric." + field.first, field.second);
+    }
+    rows_.push_back(row);
+}
+
+void Reporter::close() {
+    if (!enabled_) {
+        return;
+    }
+    if (csv_) {
+        writeCsv_();
+    }
+    if (file_.is_open()) {
+        file_.close();
+    } else {
+        std::cout.flush();
+    }
+    enabled_ = false;
+}
+
+void Reporter::writeCsv_() {
+    if (rows_.empty()) {
+        return;
+    }
+    // columns in order of first use, grouped as host, config, metrics
+    std::vector<std::string> columns;
+    std::set<std::string> seen;
+    for (const ReportFields& row : rows_) {
+        for (const auto& field : row) {
+            if (seen.insert(field.first).second) {
+                columns.push_back(field.first);
+            }
+        }
+    }
+    auto group = [](const std::string& column) -> uint32_t {
+        return (column.compare(0, 5, "host.") == 0) ? 1 :
+            (column.compare(0, 7, "config.") == 0) ? 2 :
+            (column.compare(0, 7, "metric.") == 0) ? 3 : 0;
+    };
+    std::stable_sort(columns.begin(), columns.end(),
+        [&group](const std::string& a, const std::string& b) { return group(a) < group(b); });
+    std::string out;
+    for (uint32_t i = 0; i < columns.size(); ++i) {
+        out += (i ? "," : "") + columns[i];
+    }
+    out += "\n";
+    for (const ReportFields& row : rows_) {
+        for (uint32_t i = 0; i < columns.size(); ++i) {
+            out += (i ? "," : "");
+            for (const auto& field : row) {
+                if (field.first == columns[i]) {
+                    out += csv_value(field.second);
+                    break;
+                }
+            }
+        }
+        out += "\n";
+    }
+    write_(out);
+    rows_.clear();
+}
+
+void Reporter::write_(const std::string& str) {
+    if (file_.is_open()) {
+        file_ << str;
+        file_.flush();
+    } else {
+        std::cout << str;
+    }
+}
+
+}
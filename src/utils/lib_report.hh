@@ -0,0 +1,103 @@
+#ifndef __LIB_REPORT_HH__
+#define __LIB_REPORT_HH__
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "utils/lib_options.hh"
+#include "utils/lib_stats.hh"
+
+namespace utils {
+
+// a scalar rendered once, as JSON would print it
+struct ReportValue {
+    std::string text;
+    bool quoted = false;
+
+    ReportValue() = default;
+    ReportValue(const std::string& str) : text (str), quoted (true) { }
+    ReportValue(const char* str) : text (str), quoted (true) { }
+    ReportValue(bool value) : text (value ? "true" : "false") { }
+    template <class T, class = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    ReportValue(T value) {
+        std::ostringstream out;
+        out.precision(10);
+        out << +value;
+        // inf/nan are not JSON
+        text = std::isfinite(static_cast<double>(value)) ? out.str() : "null";
+    }
+};
+
+typedef std::vector<std::pair<std::string, ReportValue>> ReportFields;
+
+// one measurement: what it ran under and what it measured, e.g.
+//   ResultRecord().config("threads", 4).metric("bw_mbps", bw)
+class ResultRecord {
+  public:
+    ResultRecord& config(const std::string& key, const ReportValue& value);
+    ResultRecord& metric(const std::string& key, const ReportValue& value);
+    // <prefix>_{n,dropped,min,median,mean,stddev,ci95}
+    ResultRecord& stats(const std::string& prefix, const SampleStats& stats);
+
+    const ReportFields& getConfig() const { return config_; }
+    const ReportFields& getMetrics() const { return metrics_; }
+
+  private:
+    ReportFields config_;
+    ReportFields metrics_;
+};
+
+// "0,2,4" for a thread->cpu map
+std::string join_list(const std::vector<uint32_t>& list);
+
+// structured results next to the text output, one record per measurement:
+//   --report=<file>: "-" for stdout
+//   --report_format=jsonl|csv: default from the file extension, else jsonl
+// jsonl streams one object per line; csv is written at exit, with a column
+// for every key any record used; without --report nothing is written
+class Reporter {
+  public:
+    static Reporter& get();
+    ~Reporter();
+    Reporter(const Reporter&) = delete;
+    Reporter& operator=(const Reporter&) = delete;
+
+    // call early, before any thread pool spins: the host block measures clocks
+    void open(const std::string& benchmark, const Options& options);
+    bool isEnabled() const { return enabled_; }
+
+    // config shared by all later records, e.g. the region size
+    void config(const std::string& key, const ReportValue& value);
+    void add(const ResultRecord& record);
+    // writes out csv; called at exit
+    void close();
+
+    const ReportFields& getHost() const { return host_; }
+
+  private:
+    Reporter() = default;
+
+    std::string toJson_(const ResultRecord& record) const;
+    void writeCsv_();
+    void write_(const std::string& str);
+
+    bool enabled_ = false;
+    bool csv_ = false;
+    std::string path_;
+    std::ofstream file_;
+    std::string benchmark_;
+    ReportFields host_;
+    ReportFields common_;
+    // flattened csv rows, held until close()
+    std::vector<ReportFields> rows_;
+};
+
+}
+
+#endif
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "utils/lib_stats.hh"
+
+namespace utils {
+
+// linear interpolation between the closest ranks
+static double quantile(const std::vector<double>& sorted, double q) {
+    const double pos = q * (sorted.size() - 1);
+    const uint32_t lo = static_cast<uint32_t>(pos);
+    const uint32_t hi = std::min<uint32_t>(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (pos - lo) * (sorted[hi] - sorted[lo]);
+}
+
+double t95(uint32_t dof) {
+    static const double table[] = {
+        0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+        2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+        2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (dof < sizeof(table) / sizeof(table[0])) {
+        return table[dof];
+    }
+    return (dof < 60) ? 2.000 : (dof < 120) ? 1.980 : 1.960;
+}
+
+SampleStats summarize(const std::vector<double>& samples, double outlier_k) {
+    SampleStats stats;
+    if (samples.empty()) {
+        return stats;
+    }
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    if (outlier_k > 0 && sorted.size() >= 4) {
+        const double q1 = quantile(sorted, 0.25);
+        const double q3 = quantile(sorted, 0.75);
+        const double low = q1 - outlier_k * (q3 - q1);
+        const double high = q3 + outlier_k * (q3 - q1);
+        std::vector<double> kept;
+        for (const double& v : sorted) {
+            if (v >= low && v <= high) {
+                kept.push_back(v);
+            }
+        }
+        stats.num_dropped = sorted.size() - kept.size();
+        sorted.swap(kept);
+    }
+    const uint32_t n = sorted.size();
+    stats.num_samples = n;
+    stats.min = sorted.front();
+    stats.median = quantile(sorted, 0.5);
+    double sum = 0;
+    for (const double& v : sorted) {
+        sum += v;
+    }
+    stats.mean = sum / n;
+    if (n > 1) {
+        double sum_squares = 0;
+        for (const double& v : sorted) {
+            sum_squares += (v - stats.mean) * (v - stats.mean);
+        }
+        stats.stddev = std::sqrt(sum_squares / (n - 1));
+        stats.ci95 = t95(n - 1) * stats.stddev / std::sqrt(n);
+    }
+    return stats;
+}
+
+RepeatConfig::RepeatConfig(const Options& options) {
+    target_rel_ci = options.getDouble("rel_ci", 0);
+    outlier_k = options.getDouble("outlier", 0);
+    if (target_rel_ci > 0) {
+        // enough samples for a meaningful CI before checking it
+        min_reps = std::max<uint32_t>(3, options.getUint("reps", 3));
+        max_reps = std::max<uint32_t>(min_reps, options.getUint("max_reps", 100));
+    } else {
+        min_reps = std::max<uint32_t>(1, options.getUint("reps", 1));
+        max_reps = min_reps;
+    }
+}
+
+void dump_stats(std::ostream& os, const std::string& tag, const std::string& unit,
+                const SampleStats& stats, double scale) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "stats <" << tag << "> " << unit << ":"
+        << " n=" << stats.num_samples << " dropped=" << stats.num_dropped
+        << " min=" << stats.min * scale << " median=" << stats.median * scale
+        << " mean=" << stats.mean * scale << " stddev=" << stats.stddev * scale
+        << " ci95=" << stats.ci95 * scale
+        << " (" << std::setprecision(2) << 100 * stats.getRelCi() << "%)" << std::endl;
+    os << out.str();
+}
+
+}
@@ -0,0 +1,94 @@
+#ifndef __LIB_STATS_HH__
+#define __LIB_STATS_HH__
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "utils/lib_options.hh"
+#include "utils/lib_timing.hh"
+
+namespace utils {
+
+struct SampleStats {
+    uint32_t num_samples = 0;
+    uint32_t num_dropped = 0;
+    double min = 0;
+    double median = 0;
+    double mean = 0;
+    double stddev = 0;
+    // half-width of the 95% confidence interval of the mean (Student's t)
+    double ci95 = 0;
+
+    double getRelCi() const { return (mean != 0) ? ci95 / (mean > 0 ? mean : -mean) : 0; }
+};
+
+// drops samples outside Tukey's fences [Q1 - k*IQR, Q3 + k*IQR] if k > 0
+// (with at least 4 samples), then summarizes the rest
+SampleStats summarize(const std::vector<double>& samples, double outlier_k=0);
+
+// two-sided 95% critical value of Student's t
+double t95(uint32_t dof);
+
+// --reps=R: R samples; --rel_ci=X: keep sampling until the CI half-width is
+// within X of the mean, up to --max_reps; --outlier=K: Tukey fence multiplier
+struct RepeatConfig {
+    uint32_t min_reps = 1;
+    uint32_t max_reps = 1;
+    double target_rel_ci = 0;
+    double outlier_k = 0;
+
+    RepeatConfig() = default;
+    explicit RepeatConfig(const Options& options);
+    // more than the single sample of a plain run
+    bool isRepeated() const { return max_reps > 1; }
+};
+
+class Repeater {
+  public:
+    explicit Repeater(const RepeatConfig& config) : config_ (config) { }
+
+    // sample() returns one measurement, e.g. the per-ref time of a phase
+    template <class Sample>
+    SampleStats collect(Sample sample) {
+        samples_.clear();
+        SampleStats stats;
+        while (samples_.size() < config_.max_reps) {
+            samples_.push_back(sample());
+            if (samples_.size() < config_.min_reps) {
+                continue;
+            }
+            stats = summarize(samples_, config_.outlier_k);
+            if (config_.target_rel_ci > 0 && stats.num_samples > 1 && stats.getRelCi() <= config_.target_rel_ci) {
+                break;
+            }
+        }
+        return stats;
+    }
+
+    // times kernel() with the TSC; metric() turns the elapsed seconds into
+    // the sample, e.g. ns per ref or bytes per second
+    template <class Kernel, class Metric>
+    SampleStats run(Kernel kernel, Metric metric) {
+        return collect([&kernel, &metric]() -> double {
+            tsc_start<TSC_PHASE>();
+            kernel();
+            return metric(tsc_stop<TSC_PHASE>() * ns_per_tick() / 1e9);
+        });
+    }
+
+    const std::vector<double>& getSamples() const { return samples_; }
+
+  private:
+    const RepeatConfig config_;
+    std::vector<double> samples_;
+};
+
+// stats <tag> <unit>: n=.. dropped=.. min=.. median=.. mean=.. stddev=.. ci95=..
+void dump_stats(std::ostream& os, const std::string& tag, const std::string& unit,
+                const SampleStats& stats, double scale=1);
+
+}
+
+#endif
@@ -1,14 +1,57 @@
 #ifndef __LIB_THREADING_HH__
 #define __LIB_THREADING_HH__
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <string>
 #include <pthread.h>
+#include <sched.h>
+
+#include "utils/lib_topology.hh"
 
 namespace utils {
 
+static inline void cpu_relax() {
+    __asm__ __volatile__("pause" ::: "memory");
+}
+
+// sense-reversing spin barrier; every thread keeps its own sense flag,
+// so the barrier can be reused back-to-back without re-initialization
+class SpinBarrier {
+  public:
+    explicit SpinBarrier(uint32_t num_threads) :
+        num_threads_ (num_threads),
+        count_ (num_threads),
+        sense_ (false)
+    { }
+    ~SpinBarrier() = default;
+
+    void wait(bool& local_sense) {
+        local_sense = !local_sense;
+        if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // last one in resets the count and releases the others
+            count_.store(num_threads_, std::memory_order_relaxed);
+            sense_.store(local_sense, std::memory_order_release);
+        } else {
+            uint32_t spins = 0;
+            while (sense_.load(std::memory_order_acquire) != local_sense) {
+                cpu_relax();
+                // only matters when oversubscribed
+                if (++spins % 4096 == 0) sched_yield();
+            }
+        }
+    }
+
+  private:
+    const uint32_t num_threads_;
+    alignas(64) std::atomic<uint32_t> count_;
+    alignas(64) std::atomic<bool> sense_;
+};
+
 class BaseThreadPacket {
   public:
     BaseThreadPacket() { }
@@ -21,14 +64,30 @@ class BaseThreadPacket {
         signature_ = "T" + std::to_string(tid) + "/C" + std::to_string(core_id);
     }
     const uint32_t& getThreadId() const { return thread_id_; }
+    const uint32_t& getCoreId() const { return core_id_; }
     const uint32_t& getNumThreads() const { return num_threads_; }
     const std::string& getSignature() const { return signature_; }
 
+    // pool mode: common start of the current phase, and this thread's
+    // [begin, end] within it in seconds
+    void setEpoch(const std::chrono::steady_clock::time_point& epoch) { epoch_ = epoch; }
+    const std::chrono::steady_clock::time_point& getEpoch() const { return epoch_; }
+    double sinceEpoch() const {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(
+            std::chrono::steady_clock::now() - epoch_).count();
+    }
+    void setPhaseWindow(double begin, double end) { phase_begin_ = begin; phase_end_ = end; }
+    const double& getPhaseBegin() const { return phase_begin_; }
+    const double& getPhaseEnd() const { return phase_end_; }
+
   private:
     uint32_t thread_id_;
     uint32_t core_id_;
     uint32_t num_threads_;
     std::string signature_;
+    std::chrono::steady_clock::time_point epoch_;
+    double phase_begin_ = 0;
+    double phase_end_ = 0;
 };
 
 template <class Packet>
@@ -37,44 +96,37 @@ class ThreadHelper {
     ThreadHelper(uint32_t num_threads, uint32_t num_cores, uint32_t thread_step, uint32_t core_id_start=0) :
         num_threads_ (num_threads),
         thread_step_ (thread_step),
-        attrs_ (num_threads),
         threads_ (num_threads),
+        attrs_ (num_threads),
         packets_ (num_threads),
-        start_routines_ (num_threads, nullptr)
+        start_routines_ (num_threads, nullptr),
+        pool_barrier_ (num_threads + 1)
     {
         if (num_cores % thread_step > 0) {
             std::cerr << "expect num_cores=" << num_threads << " to be a multiple of thread_step=" << thread_step << std::endl;
             exit(1);
         }
         const uint32_t group_size = num_cores / thread_step;
-        // prepare thread attrs
-        std::cout << "thread ID: [";
-        for (uint32_t i = 0; i < num_threads; ++i) {
-            std::cout << i;
-            if (num_threads > 100 && i < 100) std::cout << " ";
-            if (i < 10) std::cout << " ";
-            if (i < num_threads-1) std::cout << " ";
-        }
-        std::cout << "]\n core  ID: [";
+        std::vector<uint32_t> core_ids(num_threads);
         for (uint32_t i = 0; i < num_threads; ++i) {
             // get thread-core mapping
             const uint32_t group_id = i / group_size;
             const uint32_t group_offset = i % group_size;
-            const uint32_t core_id = (core_id_start + group_id + group_offset * thread_step) % num_cores;
-            std::cout << core_id;
-            if (num_threads > 100 && core_id < 100) std::cout << " ";
-            if (core_id < 10) std::cout << " ";
-            if (i < num_threads-1) std::cout << " ";
-            pthread_attr_init(&attrs_[i]);
-            cpu_set_t cpuset;
-            CPU_ZERO(&cpuset);
-            CPU_SET(core_id, &cpuset);
-            // set thread attribute
-            pthread_attr_setaffinity_np(&attrs_[i], sizeof(cpu_set_t), &cpuset);
-            // thread packets
-            packets_[i].setThreadId(i, core_id, num_threads);
+            core_ids[i] = (core_id_start + group_id + group_offset * thread_step) % num_cores;
         }
-        std::cout << "]" << std::endl;
+        setAffinity_(core_ids, true);
+    }
+    // explicit thread-core mapping, e.g. from CpuTopology::getPlacement()
+    ThreadHelper(const std::vector<uint32_t>& core_ids, bool verbose=true) :
+        num_threads_ (core_ids.size()),
+        thread_step_ (1),
+        threads_ (core_ids.size()),
+        attrs_ (core_ids.size()),
+        packets_ (core_ids.size()),
+        start_routines_ (core_ids.size(), nullptr),
+        pool_barrier_ (core_ids.size() + 1)
+    {
+        setAffinity_(core_ids, verbose);
     }
     ~ThreadHelper() = default;
 
@@ -92,7 +144,10 @@ class ThreadHelper {
 
     void create() {
         for (uint32_t i = 0; i < num_threads_; ++i) {
-            pthread_create(&threads_[i], &attrs_[i], start_routines_[i], (void*)(&packets_[i]));
+            if (pthread_create(&threads_[i], &attrs_[i], start_routines_[i], (void*)(&packets_[i])) != 0) {
+                std::cerr << "failed to create thread " << i << " on core " << packets_[i].getCoreId() << std::endl;
+                exit(1);
+            }
         }
     }
     void join() {
@@ -101,7 +156,108 @@ class ThreadHelper {
         }
     }
 
+    // pool mode: threads are created and pinned once by startPool(), then every
+    // runPhase() releases all of them into their current routine together and
+    // waits until all are done; stopPool() lets them exit
+    void startPool() {
+        assert(!pool_running_);
+        pool_running_ = true;
+        pool_stop_ = false;
+        pool_slots_.resize(num_threads_);
+        for (uint32_t i = 0; i < num_threads_; ++i) {
+            pool_slots_[i].helper = this;
+            pool_slots_[i].idx = i;
+            // the barrier's sense carries over from a previous pool
+            pool_slots_[i].sense = pool_sense_;
+        }
+        for (uint32_t i = 0; i < num_threads_; ++i) {
+            if (pthread_create(&threads_[i], &attrs_[i], poolLoop_, (void*)(&pool_slots_[i])) != 0) {
+                std::cerr << "failed to create thread " << i << " on core " << packets_[i].getCoreId() << std::endl;
+                exit(1);
+            }
+        }
+    }
+    void runPhase() {
+        assert(pool_running_);
+        const auto epoch = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < num_threads_; ++i) {
+            packets_[i].setEpoch(epoch);
+        }
+        // start, then end of the phase
+        pool_barrier_.wait(pool_sense_);
+        pool_barrier_.wait(pool_sense_);
+    }
+    void stopPool() {
+        assert(pool_running_);
+        pool_stop_ = true;
+        pool_barrier_.wait(pool_sense_);
+        join();
+        pool_running_ = false;
+    }
+
   private:
+    struct PoolSlot {
+        ThreadHelper* helper;
+        uint32_t idx;
+        bool sense;
+    };
+
+    static void* poolLoop_(void* ptr) {
+        PoolSlot* slot = static_cast<PoolSlot*>(ptr);
+        ThreadHelper* helper = slot->helper;
+        Packet& packet = helper->packets_[slot->idx];
+        bool sense = slot->sense;
+        while (true) {
+            helper->pool_barrier_.wait(sense);
+            if (helper->pool_stop_) {
+                break;
+            }
+            const double begin = packet.sinceEpoch();
+            helper->start_routines_[slot->idx]((void*)(&packet));
+            packet.setPhaseWindow(begin, packet.sinceEpoch());
+            helper->pool_barrier_.wait(sense);
+        }
+        return NULL;
+    }
+
+    void setAffinity_(const std::vector<uint32_t>& core_ids, bool verbose) {
+        const uint32_t num_threads = core_ids.size();
+        // prepare thread attrs
+        std::ostringstream out;
+        out << "thread ID: [";
+        for (uint32_t i = 0; i < num_threads; ++i) {
+            out << i;
+            if (num_threads > 100 && i < 100) out << " ";
+            if (i < 10) out << " ";
+            if (i < num_threads-1) out << " ";
+        }
+        out << "]\n core  ID: [";
+        for (uint32_t i = 0; i < num_threads; ++i) {
+            const uint32_t core_id = core_ids[i];
+            // pinning to an offline cpu or one outside the cpuset fails thread creation
+            if (!CpuTopology::get().isAllowed(core_id)) {
+                std::cerr << "core " << core_id << " is offline or outside the process cpuset" << std::endl;
+                exit(1);
+            }
+            out << core_id;
+            if (num_threads > 100 && core_id < 100) out << " ";
+            if (core_id < 10) out << " ";
+            if (i < num_threads-1) out << " ";
+            pthread_attr_init(&attrs_[i]);
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(core_id, &cpuset);
+            // set thread attribute
+            pthread_attr_setaffinity_np(&attrs_[i], sizeof(cpu_set_t), &cpuset);
+            // thread packets
+            packets_[i].setThreadId(i, core_id, num_threads);
+        }
+        out << "]" << std::endl;
+        if (verbose) {
+            std::cout << out.str();
+        }
+    }
+
     const uint32_t num_threads_;
     const uint32_t thread_step_;
 
@@ -109,6 +265,12 @@ class ThreadHelper {
     std::vector<pthread_attr_t> attrs_;
     std::vector<Packet> packets_;
     std::vector<void *(*)(void *)> start_routines_;
+    // pool mode: workers + the calling thread meet at the barrier
+    SpinBarrier pool_barrier_;
+    bool pool_running_ = false;
+    std::vector<PoolSlot> pool_slots_;
+    bool pool_sense_ = false;
+    bool pool_stop_ = false;
 };
 
 }
@@ -1,6 +1,12 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
 #include <mutex>
+#include <sstream>
 #include <unordered_map>
+#include <vector>
+#include <cpuid.h>
 
 #include "utils/lib_timing.hh"
 
@@ -21,6 +27,115 @@ void Timer::endTimer() {
 }
 
 
+uint64_t rdtscp_overhead() {
+    uint64_t overhead = UINT64_MAX;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        const uint64_t t1 = rdtscp();
+        const uint64_t t2 = rdtscp();
+        if (t2 - t1 < overhead) {
+            overhead = t2 - t1;
+        }
+    }
+    return overhead;
+}
+
+bool has_invariant_tsc() {
+    uint32_t eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0x80000000, NULL) < 0x80000007) {
+        return false;
+    }
+    __cpuid(0x80000007, eax, ebx, ecx, edx);
+    return (edx >> 8) & 1;
+}
+
+// ticks over a ~10ms busy wait, median of a few rounds
+static double calibrate_tsc_ghz() {
+    std::vector<double> rates;
+    for (uint32_t round = 0; round < 5; ++round) {
+        const auto time_begin = std::chrono::steady_clock::now();
+        const uint64_t tick_begin = rdtscp();
+        auto time_end = time_begin;
+        while (time_end - time_begin < std::chrono::milliseconds(10)) {
+            time_end = std::chrono::steady_clock::now();
+        }
+        const uint64_t tick_end = rdtscp();
+        const double elapsed_ns = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(time_end - time_begin).count();
+        rates.push_back((tick_end - tick_begin) / elapsed_ns);
+    }
+    std::sort(rates.begin(), rates.end());
+    return rates[rates.size() / 2];
+}
+
+// a chain of dependent register adds retires one per cycle (no immediates,
+// which newer cores can fold at rename); the loop control runs alongside, so
+// an iteration costs 8 cycles; best of a few rounds, after a first round
+// that lets the core ramp up
+static double measure_core_ghz() {
+    const uint64_t num_iters = 1 << 22;
+    volatile uint64_t one = 1;
+    const uint64_t step = one;
+    double best = 0;
+    for (uint32_t round = 0; round < 6; ++round) {
+        uint64_t x = 0;
+        const auto time_begin = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < num_iters; ++i) {
+            __asm__ __volatile__(
+                "add %1, %0\n\t" "add %1, %0\n\t" "add %1, %0\n\t" "add %1, %0\n\t"
+                "add %1, %0\n\t" "add %1, %0\n\t" "add %1, %0\n\t" "add %1, %0\n\t"
+                : "+r" (x) : "r" (step));
+        }
+        const auto time_end = std::chrono::steady_clock::now();
+        const double elapsed_ns = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(time_end - time_begin).count();
+        if (round > 0) {
+            best = std::max(best, num_iters * 8 / elapsed_ns);
+        }
+    }
+    return best;
+}
+
+const ClockInfo& get_clock_info() {
+    static const ClockInfo clock_info = []() -> ClockInfo {
+        ClockInfo info;
+        info.invariant_tsc = has_invariant_tsc();
+        info.tsc_ghz = calibrate_tsc_ghz();
+        info.core_ghz = measure_core_ghz();
+        return info;
+    }();
+    return clock_info;
+}
+
+void dump_clock_info(std::ostream& os) {
+    const ClockInfo& info = get_clock_info();
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "clock: tsc(GHz)=" << info.tsc_ghz << " core(GHz)=" << info.core_ghz
+        << " invariant_tsc=" << (info.invariant_tsc ? "yes" : "no") << std::endl;
+    if (!info.invariant_tsc) {
+        out << "warning: TSC is not invariant; tick-based times may drift with frequency changes" << std::endl;
+    }
+    os << out.str();
+}
+
+float resolve_core_freq(float core_freq_ghz, std::ostream& os) {
+    const double measured = get_clock_info().core_ghz;
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    if (core_freq_ghz <= 0) {
+        out << "core freq(GHz)=" << measured << " (measured)" << std::endl;
+        core_freq_ghz = measured;
+    } else {
+        out << "core freq(GHz)=" << core_freq_ghz << " (given), " << measured << " (measured)" << std::endl;
+        if (std::fabs(core_freq_ghz - measured) > 0.1 * measured) {
+            out << "warning: given core freq is more than 10% off the measured one" << std::endl;
+        }
+    }
+    os << out.str();
+    return core_freq_ghz;
+}
+
+thread_local TscSlots g_tsc_slots;
+
+
 std::unordered_map<std::string, Timer::Handle> g_timer_map;
 std::mutex g_timer_map_mu;
 
@@ -32,6 +147,28 @@ void start_timer(const std::string& timer_key) {
     g_timer_map[timer_key]->startTimer();
 }
 
+static void print_elapsed(const std::string& timer_key, std::ostream& os, double elapsed_time) {
+    std::string out_str = "timer <" + timer_key + "> elapsed:" +
+        " total(s)=" + std::to_string(elapsed_time) + "\n";
+    os << out_str;
+}
+
+static void print_per_ref(std::ostream& os, double elapsed_time, uint64_t num_refs, float core_freq_ghz) {
+    std::string out_str = "per-ref(ns)=" + std::to_string(1000000000 * elapsed_time / num_refs);
+    out_str += ", per-ref(cycle)=" + std::to_string(1000000000 * elapsed_time / num_refs * core_freq_ghz);
+    out_str += "\n\n";
+    os << out_str;
+}
+
+static void print_bw(std::ostream& os, double elapsed_time, uint64_t size, uint64_t num_iters, float core_freq_ghz) {
+    const double bw_bps = size * num_iters / elapsed_time;
+    std::string out_str = "bw(MBpS)=" + std::to_string(bw_bps / 1024 / 1024);
+    out_str += ", bw(BytesPerNs)=" + std::to_string(bw_bps / 1000000000);
+    out_str += ", bw(BytesPerCycle)=" + std::to_string(bw_bps / 1000000000 / core_freq_ghz);
+    out_str += "\n\n";
+    os << out_str;
+}
+
 float end_timer(const std::string& timer_key, std::ostream& os) {
     float elapsed_time = 0;
     {
@@ -48,31 +185,44 @@ float end_timer(const std::string& timer_key, std::ostream& os) {
             std::cerr << "Timer error ..." << std::endl;
         }
     }
-    std::string out_str = "timer <" + timer_key + "> elapsed:" +
-        " total(s)=" + std::to_string(elapsed_time) + "\n";
-    os << out_str;
+    print_elapsed(timer_key, os, elapsed_time);
     return elapsed_time;
 }
 
 void end_timer(const std::string& timer_key, std::ostream& os, uint64_t num_refs, float core_freq_ghz) {
     if (num_refs > 0) {
         const double elapsed_time = end_timer(timer_key, os);
-        std::string out_str = "per-ref(ns)=" + std::to_string(1000000000 * elapsed_time / num_refs);
-        out_str += ", per-ref(cycle)=" + std::to_string(1000000000 * elapsed_time / num_refs * core_freq_ghz);
-        out_str += "\n\n";
-        os << out_str;
+        print_per_ref(os, elapsed_time, num_refs, core_freq_ghz);
     }
 }
 
 void end_timer(const std::string& timer_key, std::ostream& os, uint64_t size, uint64_t num_iters, float core_freq_ghz) {
     if (num_iters > 0) {
         const double elapsed_time = end_timer(timer_key, os);
-        const double bw_bps = size * num_iters / elapsed_time;
-        std::string out_str = "bw(MBpS)=" + std::to_string(bw_bps / 1024 / 1024);
-        out_str += ", bw(BytesPerNs)=" + std::to_string(bw_bps / 1000000000);
-        out_str += ", bw(BytesPerCycle)=" + std::to_string(bw_bps / 1000000000 / core_freq_ghz);
-        out_str += "\n\n";
-        os << out_str;
+        print_bw(os, elapsed_time, size, num_iters, core_freq_ghz);
+    }
+}
+
+float report_ticks(const std::string& timer_key, std::ostream& os, uint64_t ticks) {
+    const float elapsed_time = ticks * ns_per_tick() / 1e9;
+    print_elapsed(timer_key, os, elapsed_time);
+    return elapsed_time;
+}
+
+void report_ticks(const std::string& timer_key, std::ostream& os, uint64_t ticks, uint64_t num_refs, float core_freq_ghz) {
+    if (num_refs > 0) {
+        // in double, a float total would round off short per-ref times
+        const double elapsed_time = ticks * ns_per_tick() / 1e9;
+        print_elapsed(timer_key, os, elapsed_time);
+        print_per_ref(os, elapsed_time, num_refs, core_freq_ghz);
+    }
+}
+
+void report_ticks(const std::string& timer_key, std::ostream& os, uint64_t ticks, uint64_t size, uint64_t num_iters, float core_freq_ghz) {
+    if (num_iters > 0) {
+        const double elapsed_time = ticks * ns_per_tick() / 1e9;
+        print_elapsed(timer_key, os, elapsed_time);
+        print_bw(os, elapsed_time, size, num_iters, core_freq_ghz);
     }
 }
 
@@ -2,6 +2,7 @@
 #define __LIB_TIMING_HH__
 
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -27,11 +28,100 @@ class Timer {
 };
 
 
+// time-stamp counter; rdtscp waits for all prior instructions (incl. loads)
+// to complete, the trailing lfence keeps later ones from starting early
+static inline uint64_t rdtscp() {
+    uint32_t lo, hi, aux;
+    __asm__ __volatile__("rdtscp" : "=a" (lo), "=d" (hi), "=c" (aux));
+    __asm__ __volatile__("lfence" ::: "memory");
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+// no ordering; for timestamps where a few cycles of skew don't matter
+static inline uint64_t rdtsc() {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+// minimal cost of a back-to-back rdtscp pair, in ticks
+uint64_t rdtscp_overhead();
+
+// cpuid 0x80000007: the TSC ticks at a constant rate across P/C-states
+bool has_invariant_tsc();
+
+// measured once, on first use
+struct ClockInfo {
+    bool invariant_tsc;
+    // TSC rate, calibrated against steady_clock
+    double tsc_ghz;
+    // core clock of the calling cpu, from a chain of dependent adds
+    double core_ghz;
+};
+const ClockInfo& get_clock_info();
+void dump_clock_info(std::ostream& os);
+
+static inline double ns_per_tick() { return 1 / get_clock_info().tsc_ghz; }
+
+// core frequency for cycle numbers: the measured one if the user gave 0,
+// otherwise the given one, with a warning if it is off by more than 10%
+float resolve_core_freq(float core_freq_ghz, std::ostream& os);
+
+
+// per-thread TSC timers keyed by compile-time IDs: no lock, no lookup,
+// no allocation; the ticks accumulate until cleared
+enum TscTimerId : uint32_t {
+    TSC_WARMUP = 0,
+    TSC_MAIN,
+    TSC_PHASE,
+    TSC_USER,
+    MAX_TSC_TIMERS = 16,
+};
+
+struct TscSlots {
+    uint64_t begin[MAX_TSC_TIMERS];
+    uint64_t ticks[MAX_TSC_TIMERS];
+};
+extern thread_local TscSlots g_tsc_slots;
+
+template <uint32_t ID>
+inline void tsc_start() {
+    static_assert(ID < MAX_TSC_TIMERS, "TSC timer ID out of range");
+    g_tsc_slots.begin[ID] = rdtscp();
+}
+
+// returns the ticks of this interval
+template <uint32_t ID>
+inline uint64_t tsc_stop() {
+    static_assert(ID < MAX_TSC_TIMERS, "TSC timer ID out of range");
+    const uint64_t ticks = rdtscp() - g_tsc_slots.begin[ID];
+    g_tsc_slots.ticks[ID] += ticks;
+    return ticks;
+}
+
+template <uint32_t ID>
+inline uint64_t tsc_ticks() {
+    static_assert(ID < MAX_TSC_TIMERS, "TSC timer ID out of range");
+    return g_tsc_slots.ticks[ID];
+}
+
+template <uint32_t ID>
+inline void tsc_clear() {
+    static_assert(ID < MAX_TSC_TIMERS, "TSC timer ID out of range");
+    g_tsc_slots.ticks[ID] = 0;
+}
+
+
 void start_timer(const std::string& timer_key);
 float end_timer(const std::string& timer_key, std::ostream& os);
 void end_timer(const std::string& timer_key, std::ostream& os, uint64_t num_refs, float core_freq_ghz);
 void end_timer(const std::string& timer_key, std::ostream& os, uint64_t size, uint64_t num_iters, float core_freq_ghz);
 
+// same output as end_timer, from a TSC interval
+float report_ticks(const std::string& timer_key, std::ostream& os, uint64_t ticks);
+void report_ticks(const std::string& timer_key, std::ostream& os, uint64_t ticks, uint64_t num_refs, float core_freq_ghz);
+void report_ticks(const std::string& timer_key, std::ostream& os, uint64_t ticks, uint64_t size, uint64_t num_iters, float core_freq_ghz);
+
 }
 
 #endif
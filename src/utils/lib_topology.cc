@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <numa.h>       // numa_*
+#include <sched.h>      // sched_getaffinity
+
+#include "utils/lib_topology.hh"
+
+namespace utils {
+
+std::vector<uint32_t> parse_cpu_list(const std::string& str) {
+    std::vector<uint32_t> cpus;
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        const size_t dash = item.find('-');
+        const uint32_t first = std::strtoul(item.substr(0, dash).c_str(), NULL, 10);
+        const uint32_t last = (dash == std::string::npos) ? first : std::strtoul(item.substr(dash + 1).c_str(), NULL, 10);
+        for (uint32_t cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+static std::string read_sysfs(const std::string& path) {
+    std::ifstream file(path);
+    std::string value;
+    std::getline(file, value);
+    return value;
+}
+
+static std::string cpu_path(uint32_t cpu, const std::string& attr) {
+    return "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/" + attr;
+}
+
+// cache/index3 is usually the L3, but check the level
+static std::string find_l3_cpu_list(uint32_t cpu) {
+    for (uint32_t idx = 0; idx < 8; ++idx) {
+        const std::string index = "cache/index" + std::to_string(idx) + "/";
+        const std::string level = read_sysfs(cpu_path(cpu, index + "level"));
+        if (level.empty()) {
+            break;
+        }
+        if (level == "3") {
+            return read_sysfs(cpu_path(cpu, index + "shared_cpu_list"));
+        }
+    }
+    return "";
+}
+
+const CpuTopology& CpuTopology::get() {
+    static const CpuTopology topology;
+    return topology;
+}
+
+CpuTopology::CpuTopology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(cpu_set_t), &allowed);
+    const bool has_numa = (numa_available() >= 0);
+    std::vector<uint32_t> online = parse_cpu_list(read_sysfs("/sys/devices/system/cpu/online"));
+    for (const uint32_t& cpu : online) {
+        if (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        CpuInfo info;
+        info.cpu = cpu;
+        info.core_id = std::strtoul(read_sysfs(cpu_path(cpu, "topology/core_id")).c_str(), NULL, 10);
+        info.package_id = std::strtoul(read_sysfs(cpu_path(cpu, "topology/physical_package_id")).c_str(), NULL, 10);
+        const std::vector<uint32_t> l3_cpus = parse_cpu_list(find_l3_cpu_list(cpu));
+        info.l3_id = l3_cpus.empty() ? info.package_id : l3_cpus[0];
+        info.node_id = has_numa ? numa_node_of_cpu(cpu) : -1;
+        // counted over the allowed siblings, so each core's first allowed cpu gets 0
+        info.smt_index = 0;
+        for (const uint32_t& sibling : parse_cpu_list(read_sysfs(cpu_path(cpu, "topology/thread_siblings_list")))) {
+            if (sibling == cpu) {
+                break;
+            }
+            if (sibling < CPU_SETSIZE && CPU_ISSET(sibling, &allowed)) {
+                ++ info.smt_index;
+            }
+        }
+        cpus_.push_back(info);
+    }
+    if (cpus_.empty()) {
+        std::cerr << "failed to discover cpu topology" << std::endl;
+        exit(1);
+    }
+}
+
+bool CpuTopology::isAllowed(uint32_t cpu) const {
+    for (const CpuInfo& info : cpus_) {
+        if (info.cpu == cpu) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const CpuInfo& CpuTopology::getCpu(uint32_t cpu) const {
+    for (const CpuInfo& info : cpus_) {
+        if (info.cpu == cpu) {
+            return info;
+        }
+    }
+    std::cerr << "cpu " << cpu << " is offline or outside the process cpuset" << std::endl;
+    exit(1);
+}
+
+std::vector<uint32_t> CpuTopology::getPlacement(
+    const std::string& policy, uint32_t num_threads, uint32_t thread_step, uint32_t core_id_start) const
+{
+    std::vector<CpuInfo> order = cpus_;
+    auto by_location = [](const CpuInfo& a, const CpuInfo& b) -> bool {
+        if (a.package_id != b.package_id) return a.package_id < b.package_id;
+        if (a.l3_id != b.l3_id) return a.l3_id < b.l3_id;
+        if (a.core_id != b.core_id) return a.core_id < b.core_id;
+        return a.cpu < b.cpu;
+    };
+    // first hyper-threads before second ones
+    auto by_smt_then_location = [&by_location](const CpuInfo& a, const CpuInfo& b) -> bool {
+        if (a.smt_index != b.smt_index) return a.smt_index < b.smt_index;
+        return by_location(a, b);
+    };
+    std::vector<uint32_t> core_ids;
+    if (policy.empty() || policy == "step") {
+        // same arithmetic as before, but over the allowed cpus only
+        const uint32_t num_cores = cpus_.size();
+        if (thread_step == 0 || num_cores % thread_step > 0) {
+            std::cerr << "expect num_cores=" << num_cores << " to be a multiple of thread_step=" << thread_step << std::endl;
+            exit(1);
+        }
+        const uint32_t group_size = num_cores / thread_step;
+        for (uint32_t i = 0; i < num_threads; ++i) {
+            const uint32_t group_id = i / group_size;
+            const uint32_t group_offset = i % group_size;
+            core_ids.push_back(cpus_[(core_id_start + group_id + group_offset * thread_step) % num_cores].cpu);
+        }
+        return core_ids;
+    } else if (policy == "compact") {
+        std::sort(order.begin(), order.end(), by_location);
+    } else if (policy == "scatter") {
+        // per package, one thread per core first; then interleave the packages
+        std::sort(order.begin(), order.end(), by_smt_then_location);
+        std::map<uint32_t, std::vector<CpuInfo>> packages;
+        for (const CpuInfo& info : order) {
+            packages[info.package_id].push_back(info);
+        }
+        order.clear();
+        for (uint32_t i = 0; order.size() < cpus_.size(); ++i) {
+            for (const auto& package : packages) {
+                if (i < package.second.size()) {
+                    order.push_back(package.second[i]);
+                }
+            }
+        }
+    } else if (policy == "core") {
+        std::sort(order.begin(), order.end(), by_location);
+        order.erase(std::remove_if(order.begin(), order.end(),
+            [](const CpuInfo& info) { return info.smt_index > 0; }), order.end());
+    } else if (policy == "l3") {
+        std::sort(order.begin(), order.end(), by_smt_then_location);
+        std::vector<CpuInfo> firsts;
+        for (const CpuInfo& info : order) {
+            bool seen = false;
+            for (const CpuInfo& first : firsts) {
+                seen |= (first.l3_id == info.l3_id && first.package_id == info.package_id);
+            }
+            if (!seen) {
+                firsts.push_back(info);
+            }
+        }
+        std::sort(firsts.begin(), firsts.end(), by_location);
+        order = firsts;
+    } else if (!policy.empty() && std::isdigit(policy[0])) {
+        order.clear();
+        for (const uint32_t& cpu : parse_cpu_list(policy)) {
+            order.push_back(getCpu(cpu));
+        }
+    } else {
+        std::cerr << "unknown placement: " << policy << std::endl;
+        exit(1);
+    }
+    if (order.size() < num_threads) {
+        std::cerr << "placement " << policy << " has only " << order.size()
+                  << " cpus for " << num_threads << " threads" << std::endl;
+        exit(1);
+    }
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        core_ids.push_back(order[i].cpu);
+    }
+    return core_ids;
+}
+
+void CpuTopology::dump(std::ostream& os) const {
+    std::ostringstream out;
+    out << std::setw(6) << "cpu" << std::setw(6) << "core" << std::setw(6) << "smt"
+        << std::setw(8) << "socket" << std::setw(6) << "l3" << std::setw(6) << "node" << std::endl;
+    for (const CpuInfo& info : cpus_) {
+        out << std::setw(6) << info.cpu << std::setw(6) << info.core_id << std::setw(6) << info.smt_index
+            << std::setw(8) << info.package_id << std::setw(6) << info.l3_id << std::setw(6) << info.node_id << std::endl;
+    }
+    os << out.str();
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef __LIB_TOPOLOGY_HH__
+#define __LIB_TOPOLOGY_HH__
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+// e.g. "0-3,8,10-11"
+std::vector<uint32_t> parse_cpu_list(const std::string& str);
+
+struct CpuInfo {
+    uint32_t cpu;
+    uint32_t core_id;
+    uint32_t package_id;
+    // first cpu sharing the L3; package_id if there is no L3
+    uint32_t l3_id;
+    // -1 without libnuma
+    int32_t node_id;
+    // position among the core's hyper-threads in the cpuset
+    uint32_t smt_index;
+};
+
+// cpus that are online and in the process's affinity mask (i.e. the cpuset),
+// read from /sys/devices/system/cpu/cpu*/{topology,cache}
+class CpuTopology {
+  public:
+    static const CpuTopology& get();
+
+    const std::vector<CpuInfo>& getCpus() const { return cpus_; }
+    uint32_t numCpus() const { return cpus_.size(); }
+    bool isAllowed(uint32_t cpu) const;
+    const CpuInfo& getCpu(uint32_t cpu) const;
+
+    // thread->cpu mapping for a placement policy:
+    //   compact: fill hyper-threads, cores, L3s, then packages in order
+    //   scatter: round-robin across packages, one thread per core first
+    //   core: one thread per physical core
+    //   l3: one thread per L3 domain
+    //   <cpu list>: explicit, e.g. 0-3,8
+    //   step (or empty): the thread_step formula over all cpus, as before
+    std::vector<uint32_t> getPlacement(
+        const std::string& policy, uint32_t num_threads,
+        uint32_t thread_step=1, uint32_t core_id_start=0) const;
+
+    void dump(std::ostream& os) const;
+
+  private:
+    CpuTopology();
+
+    std::vector<CpuInfo> cpus_;
+};
+
+}
+
+#endif